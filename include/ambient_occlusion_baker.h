@@ -0,0 +1,70 @@
+#ifndef __AMBIENT_OCCLUSION_BAKER_H__
+#define __AMBIENT_OCCLUSION_BAKER_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <geometry.h>
+
+namespace Dental {
+  // 在后台线程对每个顶点向法向半球发射射线, 统计被模型自身遮挡的比例,
+  // 结果由GL线程每帧取回并设置为geometry的遮蔽属性
+  class AmbientOcclusionBaker {
+  public:
+    // 每个顶点的射线数
+    static const unsigned int RAYS = 32;
+
+    // 射线长度相对包围球半径的比例, 只统计附近的遮挡
+    static constexpr float DISTANCE_RATIO = 0.1f;
+
+    ~AmbientOcclusionBaker();
+
+    AmbientOcclusionBaker& operator = (AmbientOcclusionBaker&&) noexcept = delete;
+    AmbientOcclusionBaker& operator = (const AmbientOcclusionBaker&) = delete;
+    AmbientOcclusionBaker(const AmbientOcclusionBaker&) = delete;
+    AmbientOcclusionBaker(AmbientOcclusionBaker&&) noexcept = delete;
+
+    static AmbientOcclusionBaker& instance();
+
+    // 复制geometry的顶点, 法向和三角形后排队烘焙; 没有三角形时返回false
+    bool request(const GeometryPtr& geometry);
+
+    // 是否有已完成的结果等待frame()取回
+    bool ready() const;
+
+    // 每帧在GL线程调用, 返回本次设置了遮蔽的geometry个数;
+    // 烘焙期间geometry被修改时结果作废
+    unsigned int frame();
+
+    // 同步计算每个顶点的遮蔽, 1为不遮挡; stop非空且为true时提前返回
+    static std::vector<float> bake(const std::vector<glm::vec3>& vertices,
+                                   const std::vector<glm::vec3>& normals,
+                                   const std::vector<unsigned int>& indices,
+                                   const std::atomic<bool>* stop = nullptr);
+
+  private:
+    AmbientOcclusionBaker();
+
+    struct Job {
+      std::weak_ptr<Geometry> geometry;
+      unsigned int revision;
+      std::vector<glm::vec3> vertices;
+      std::vector<glm::vec3> normals;
+      std::vector<unsigned int> indices;
+      std::vector<float> occlusion;
+    };
+
+    void run();
+
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<Job> pending_;
+    std::vector<Job> finished_;
+    std::atomic<bool> stop_;
+    std::thread thread_;
+  };
+}
+#endif
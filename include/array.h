@@ -6,14 +6,15 @@
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
 #include <glad/glad.h>
-#include <gl_object.h>
+#include <gl_buffer_object.h>
 
 namespace Dental {
-  class GLArrayObject : public GLObject {
+  class GLArrayObject : public GLBufferObject {
   public:
     GLArrayObject(short data_type_size, short gl_data_size, unsigned long gl_data_type);
-    ~GLArrayObject() override { release(); }
+    ~GLArrayObject() override {}
 
     GLArrayObject& operator = (GLArrayObject&&) noexcept = delete;
     GLArrayObject& operator = (const GLArrayObject&) = delete;
@@ -22,36 +23,58 @@ namespace Dental {
   
     void bindIndex(unsigned int index);
 
-    void bindData(GLsizeiptr data_size, void *data);
+    // 非0时每divisor个实例取一个元素
+    void divisor(unsigned int divisor);
+    inline unsigned int divisor() const { return divisor_; }
 
     virtual void bind() override;
 
     virtual void unbind() override;
 
-    virtual void release() override;
-
-    virtual void dirty() override;
-
     virtual bool valid() override;
 
   private:
+    int columns() const;
+
     struct Profile {
-      short data_type_size;
       short gl_data_size;
       unsigned long gl_data_type;
     } profile_;
 
     int index_;
-    unsigned int vbo_;
-    GLsizeiptr data_size_;
-    void* data_;
-    bool dirty_;
+    unsigned int divisor_;
   };
 
   using GLArrayObjectPtr = std::shared_ptr<GLArrayObject>;
 
+  class ArrayBase;
+  using ArrayBasePtr = std::shared_ptr<ArrayBase>;
+
+  // 与元素类型无关的接口, 用于Geometry的额外顶点属性
+  class ArrayBase {
+  public:
+    virtual ~ArrayBase() {}
+
+    virtual void bind(unsigned int index) = 0;
+
+    virtual void dirty() = 0;
+
+    // 包括已释放到GL缓冲中的元素
+    virtual std::size_t numElements() const = 0;
+
+    // 上传后释放内存中的数据, 返回释放的字节数
+    virtual std::size_t releaseData() = 0;
+
+    // 从GL缓冲读回释放的数据
+    virtual bool restoreData() = 0;
+
+    virtual ArrayBasePtr cloneArray() const = 0;
+
+    virtual GLObjectPtr GLObject() const = 0;
+  };
+
   template<typename TYPE, unsigned long GLTYPE, unsigned int GLSIZE>
-  class Array : public std::vector<TYPE> {
+  class Array : public std::vector<TYPE>, public ArrayBase {
   public:
     using base_type = std::vector<TYPE>;
     using self_type = Array<TYPE, GLTYPE, GLSIZE>;
@@ -59,13 +82,13 @@ namespace Dental {
     Array() : gl_object_(std::make_shared<GLArrayObject>(sizeof(TYPE), GLSIZE, GLTYPE)) {
     }
 
-    Array(const self_type &rhs) {
+    Array(const self_type &rhs) : Array() {
       if (this != &rhs) {
         *this = rhs;
       }
     }
 
-    Array(self_type&& rhs) noexcept {
+    Array(self_type&& rhs) noexcept : Array() {
       if (this != &rhs) {
         *this = std::move(rhs);
       }
@@ -92,17 +115,56 @@ namespace Dental {
       dirty();
     }
 
-    inline void bind(unsigned int index) {
+    inline void bind(unsigned int index) override {
       gl_object_->bindIndex(index);
       gl_object_->bindData(base_type::size(), base_type::data());
     }
 
-    inline void dirty() {
+    inline void dirty() override {
       gl_object_->bindData(base_type::size(), base_type::data());
       gl_object_->dirty();
     }
 
-    GLObjectPtr GLObject() const {
+    // 只更新[first, first + count)的元素, 其余部分不重新上传
+    inline void dirty(std::size_t first, std::size_t count) {
+      gl_object_->bindData(base_type::size(), base_type::data());
+      gl_object_->dirtyRange(first, count);
+    }
+
+    inline void divisor(unsigned int divisor) {
+      gl_object_->divisor(divisor);
+    }
+
+    inline std::size_t numElements() const override {
+      return base_type::empty() ? (std::size_t)gl_object_->dataSize() : base_type::size();
+    }
+
+    std::size_t releaseData() override {
+      auto bytes = base_type::capacity() * sizeof(TYPE);
+      base_type().swap(*this);
+      gl_object_->releaseData();
+      return bytes;
+    }
+
+    bool restoreData() override {
+      if (!base_type::empty() || !gl_object_->dataSize()) {
+        return true;
+      }
+
+      base_type::resize(gl_object_->dataSize());
+      if (!gl_object_->read(base_type::data())) {
+        base_type().swap(*this);
+        return false;
+      }
+      gl_object_->bindData(base_type::size(), base_type::data());
+      return true;
+    }
+
+    ArrayBasePtr cloneArray() const override {
+      return std::make_shared<self_type>(*this);
+    }
+
+    GLObjectPtr GLObject() const override {
       return gl_object_;
     }
 
@@ -110,6 +172,9 @@ namespace Dental {
     GLArrayObjectPtr gl_object_;
   };
 
+  using FloatArray = Array<float, GL_FLOAT, 1>;
+  using FloatArrayPtr = std::shared_ptr<FloatArray>;
+
   using Vec2Array = Array<glm::vec2, GL_FLOAT, 2>;
   using Vec2ArrayPtr = std::shared_ptr<Vec2Array>;
 
@@ -118,5 +183,9 @@ namespace Dental {
 
   using Vec4Array = Array<glm::vec4, GL_FLOAT, 4>;
   using Vec4ArrayPtr = std::shared_ptr<Vec4Array>;
+
+  // 矩阵按列占用index开始的四个attribute location
+  using Mat4Array = Array<glm::mat4, GL_FLOAT, 4>;
+  using Mat4ArrayPtr = std::shared_ptr<Mat4Array>;
 }
 #endif
\ No newline at end of file
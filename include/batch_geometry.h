@@ -0,0 +1,86 @@
+#ifndef __BATCH_GEOMETRY_H__
+#define __BATCH_GEOMETRY_H__
+
+#include <vector>
+#include <geometry.h>
+#include <mesh_optimizer.h>
+
+namespace Dental {
+  class BatchGeometry;
+  using BatchGeometryPtr = std::shared_ptr<BatchGeometry>;
+
+  // 多个geometry合并到一组顶点和索引缓冲中, 每个对象保留独立的变换和可见性;
+  // 沿用合并前的technique, technique按ProgramVariant::BATCH从变换纹理读取对象的变换
+  class BatchGeometry : public Geometry {
+  public:
+    // 变换矩阵纹理使用的纹理单元
+    static const unsigned int TRANSFORM_UNIT = 1;
+
+    struct Object {
+      std::string name;
+      unsigned int first;
+      unsigned int count;
+      glm::mat4 transform;
+      bool visible;
+      BoundingBox box;
+    };
+
+    BatchGeometry();
+    ~BatchGeometry() override;
+
+    Mate_Geometry(Dental, BatchGeometry)
+
+    BatchGeometry& operator = (const BatchGeometry&) = delete;
+    BatchGeometry& operator = (BatchGeometry&&) noexcept = delete;
+    BatchGeometry(const BatchGeometry&) = delete;
+    BatchGeometry(BatchGeometry&&) noexcept = delete;
+
+    // 按RenderTechnique实例, 纹理和颜色/纹理坐标的有无分组合并, 保持原有顺序; 跳过不能合并的geometry
+    static std::vector<BatchGeometryPtr> create(const std::vector<GeometryPtr>& geometries);
+
+    // 普通Geometry, 只有TRIANGLES图元, 没有额外的顶点属性和0号以外的纹理, 且technique支持BATCH变体
+    static bool batchable(const Geometry& geometry);
+
+    // 把node中三角形少于max_triangles的可合并geometry加入同组的BatchGeometry, 没有时在第一个成员处新建;
+    // 只有一个成员的组不合并, 返回合并的geometry个数
+    static unsigned int merge(Node& node, unsigned int max_triangles = MeshOptimizer::MIN_CLUSTERED_TRIANGLES);
+
+    // 只合并TRIANGLES图元, 返回对象编号; 初始变换为geometry的mv
+    unsigned int add(const Geometry& geometry);
+
+    inline unsigned int numObjects() const { return (unsigned int)objects_.size(); }
+    inline const Object& object(unsigned int index) const { return objects_[index]; }
+
+    // 只更新变换纹理的一行, 不重新上传顶点
+    void transform(unsigned int index, const glm::mat4& transform);
+
+    // 隐藏的对象在绘制时跳过其索引范围
+    void visible(unsigned int index, bool visible);
+
+    ProgramVariant programVariant() const override { return ProgramVariant::BATCH; }
+
+    // 上传或绑定变换纹理
+    void bindVariant(Program& program) override;
+
+  protected:
+    void computeBounding() override;
+
+    void drawPrimitives() override;
+
+  private:
+    void uploadTransforms();
+
+    void dirtyTransform(unsigned int index);
+
+    std::vector<Object> objects_;
+
+    FloatArrayPtr object_array_;
+    DrawElementsUIntPtr elements_;
+
+    unsigned int transform_texture_;
+    unsigned int transform_rows_;
+    unsigned int dirty_first_;
+    unsigned int dirty_last_;
+  };
+}
+#endif
@@ -0,0 +1,25 @@
+#ifndef __CLUSTER_H__
+#define __CLUSTER_H__
+
+#include <vector>
+#include <glm/vec3.hpp>
+#include <bounding_sphere.h>
+
+namespace Dental {
+  // 第一个图元中一段连续的三角形, 由MeshOptimizer::buildClusters生成
+  struct Cluster {
+    // 索引的起始位置和个数
+    unsigned int first;
+    unsigned int count;
+
+    // 模型空间的包围球
+    BoundingSphere sphere;
+
+    // 法向锥: 所有三角形法向与axis的夹角不超过锥角, cutoff为锥角的正弦, 大于1时不做背面裁剪
+    glm::vec3 axis;
+    float cutoff;
+  };
+
+  using Clusters = std::vector<Cluster>;
+}
+#endif
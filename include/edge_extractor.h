@@ -0,0 +1,67 @@
+#ifndef __EDGE_EXTRACTOR_H__
+#define __EDGE_EXTRACTOR_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <geometry.h>
+#include <mesh_optimizer.h>
+
+namespace Dental {
+  // 在后台线程用MeshOptimizer::extractEdges提取边, 由GL线程每帧取回并设置为geometry的叠加图元
+  class EdgeExtractor {
+  public:
+    ~EdgeExtractor();
+
+    EdgeExtractor& operator = (EdgeExtractor&&) noexcept = delete;
+    EdgeExtractor& operator = (const EdgeExtractor&) = delete;
+    EdgeExtractor(const EdgeExtractor&) = delete;
+    EdgeExtractor(EdgeExtractor&&) noexcept = delete;
+
+    static EdgeExtractor& instance();
+
+    // 复制geometry的顶点和三角形后排队提取; 同一revision已在排队时不重复复制;
+    // 数据无法读回时返回false
+    bool request(const GeometryPtr& geometry);
+
+    // 是否有已完成的结果等待frame()取回
+    bool ready() const;
+
+    // 每帧在GL线程调用, 返回本次设置了叠加图元的geometry个数;
+    // 提取期间geometry被修改时结果作废
+    unsigned int frame();
+
+    // 最近一次取回的结果在后台线程的耗时
+    inline float milliseconds() const { return milliseconds_; }
+
+  private:
+    EdgeExtractor();
+
+    struct Job {
+      std::weak_ptr<Geometry> geometry;
+      const Geometry* key;
+      unsigned int revision;
+      std::vector<glm::vec3> vertices;
+      std::vector<unsigned int> indices;
+      MeshOptimizer::Edges edges;
+      float milliseconds;
+    };
+
+    void run();
+
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<Job> pending_;
+    std::vector<Job> finished_;
+    // 排队或提取中的geometry和revision
+    std::map<const Geometry*, unsigned int> requested_;
+    float milliseconds_;
+    std::atomic<bool> stop_;
+    std::thread thread_;
+  };
+}
+#endif
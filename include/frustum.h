@@ -0,0 +1,32 @@
+#ifndef __FRUSTUM_H__
+#define __FRUSTUM_H__
+
+#include <glm/mat4x4.hpp>
+#include <bounding_box.h>
+#include <bounding_sphere.h>
+
+namespace Dental {
+  // 由投影和模型视图矩阵提取的六个裁剪面, 位于该模型视图的模型空间
+  class Frustum {
+  public:
+    enum class Result {
+      OUTSIDE,
+      INTERSECT,
+      INSIDE
+    };
+
+    Frustum();
+    explicit Frustum(const glm::mat4& mvp);
+
+    void set(const glm::mat4& mvp);
+
+    // 无效的包围体按相交处理, 不会被裁剪
+    Result test(const BoundingSphere& sphere) const;
+    Result test(const BoundingBox& box) const;
+
+  private:
+    // 左右下上近远, xyz为指向内侧的单位法向
+    glm::vec4 planes_[6];
+  };
+}
+#endif
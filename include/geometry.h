@@ -1,14 +1,19 @@
 #ifndef __GEOMETRY_H__
 #define __GEOMETRY_H__
 
+#include <array>
 #include <memory>
 #include <string>
+#include <map>
 #include <unordered_map>
 #include <array.h>
 #include <primitive_set.h>
 #include <texture.h>
+#include <gl_vertex_array_object.h>
 #include <render_technique.h>
 #include <bounding_box.h>
+#include <cluster.h>
+#include <frustum.h>
 #include <visitor.h>
 
 namespace Dental {
@@ -26,12 +31,40 @@ namespace Dental {
   class Geometry : public std::enable_shared_from_this<Geometry> {
   public:
     using TextureMap = std::unordered_map<unsigned int, TexturePtr>;
+    using AttribArrayMap = std::map<unsigned int, ArrayBasePtr>;
 
     enum class Attrib {
       POSITION = 0,
       NORMAL = 1,
       COLOR = 2,
-      TEXCOORD = 3
+      TEXCOORD = 3,
+      OBJECT = 4,
+      // 实例属性, 变换矩阵占5~8
+      INSTANCE_TRANSFORM = 5,
+      INSTANCE_COLOR = 9,
+      // 每顶点一个标量, 由ScalarRenderTechnique映射为颜色
+      SCALAR = 10,
+      // 烘焙的环境光遮蔽, 1为不遮挡
+      OCCLUSION = 11
+    };
+
+    // 叠加在模型上绘制的线, 由MeshOptimizer::extractEdges提取
+    enum class Overlay {
+      // 所有不重复的边, 即线框
+      EDGES = 0,
+      // 只属于一个三角形或超过两个三角形的边, 如扫描的开口边缘
+      BOUNDARY_EDGES = 1,
+      // 两侧面法向夹角超过阈值的边
+      CREASE_EDGES = 2
+    };
+
+    static const unsigned int OVERLAY_COUNT = 3;
+
+    enum class Residency {
+      // 内存中一直保留顶点和索引
+      KEEP,
+      // 上传到GL缓冲后释放内存中的数据, 需要时用restore()读回
+      RELEASE_AFTER_UPLOAD
     };
 
     Geometry();
@@ -54,7 +87,7 @@ namespace Dental {
     inline void name(const std::string& name) { name_ = name; }
     inline const std::string& name() const { return name_; }
 
-    inline void mv(const glm::mat4& mv) { mv_ = mv; }
+    inline void mv(const glm::mat4& mv) { mv_ = mv; dirtyBounding(); }
     inline const glm::mat4& mv() const { return mv_; }
 
     inline void uuid(const std::string& id) { uuid_ = id; }
@@ -86,6 +119,21 @@ namespace Dental {
     inline Vec4ArrayPtr colorArray() { return color_array_; }
     inline Vec2ArrayPtr texcoordArray() { return texcoord_array_; }
 
+    // 四个标准属性之外的顶点属性, index为attribute location
+    void attribArray(unsigned int index, const ArrayBasePtr& array);
+    ArrayBasePtr attribArray(unsigned int index) const;
+    void removeAttribArray(unsigned int index);
+    inline const AttribArrayMap& attribArrays() const { return attrib_arrays_; }
+
+    // Attrib::SCALAR的属性数组, 没有时返回空
+    void scalarArray(const FloatArrayPtr& array);
+    FloatArrayPtr scalarArray() const;
+
+    // Attrib::OCCLUSION的属性数组, 只影响着色, 设置时不改变revision,
+    // 简化层级和依赖顶点的缓存依然有效
+    void occlusionArray(const FloatArrayPtr& array);
+    FloatArrayPtr occlusionArray() const;
+
     void addPrimitiveSet(const PrimitiveSetPtr& primitive_set);
     void setPrimitiveSet(const PrimitiveSetPtr& primitive_set);
     PrimitiveSetPtr primitiveSet(unsigned int index = 0) const;
@@ -104,34 +152,123 @@ namespace Dental {
     void dirty();
     void dirtyBounding();
 
+    // 顶点或图元每次修改后递增, 用于判断缓存的结果是否过期
+    inline unsigned int revision() const { return revision_; }
+
+    // 只局部更新数组(如Array::dirty(first, count))时调用, 不重新设置GL对象
+    inline void touch() { ++revision_; }
+
     BoundingSphere &boundingSphere();
 
+    // 模型空间的包围盒, 与包围球一起更新; 子类没有单一模型空间时无效
+    const BoundingBox& localBoundingBox();
+
     void renderTechnique(const RenderTechniquePtr& technique);
     RenderTechniquePtr& renderTechnique();
     const RenderTechniquePtr& renderTechnique() const;
 
     virtual BoundingBox boundingBox() const;
 
+    // 第一个图元的分簇, 设置后RenderVisitor按视锥和法向锥逐簇裁剪; 修改图元后失效
+    void clusters(const Clusters& clusters);
+    inline const Clusters& clusters() const { return clusters_; }
+
+    // frustum和eye位于模型空间, 正交投影时eye为视线方向; 返回可见的簇个数
+    unsigned int cullClusters(const Frustum& frustum, const glm::vec3& eye, bool perspective);
+
+    // 下次绘制全部簇
+    void uncullClusters();
+
+    // 为false时忽略裁剪结果绘制全部簇, 如阴影深度图
+    inline void clusterCulling(bool culling) { cluster_culling_ = culling; }
+    inline bool clusterCulling() const { return cluster_culling_; }
+
+    // 简化层级, 第i个的三角形约为原模型的1/4^(i+1), 由LodGenerator在后台生成;
+    // triangles为原模型的三角形数, 数据释放后依然可以按三角形数选择层级
+    void lods(const std::vector<GeometryPtr>& lods, unsigned int triangles);
+    inline const std::vector<GeometryPtr>& lods() const { return lods_; }
+
+    // 第level层的三角形数, 0为原模型
+    inline unsigned int lodTriangles(unsigned int level) const {
+      return level < lod_triangles_.size() ? lod_triangles_[level] : 0;
+    }
+
+    // 叠加图元不由renderTechnique绘制, 不随RELEASE_AFTER_UPLOAD释放; 设置时不改变revision
+    void overlay(Overlay overlay, const PrimitiveSetPtr& primitive_set);
+    PrimitiveSetPtr overlay(Overlay overlay) const;
+
+    // 设置叠加图元后顶点或图元被修改时失效, 需要重新提取
+    bool overlaysValid() const;
+
+    // 在当前program下提交叠加图元; geometry还没有绘制过, 没有叠加图元或未上传完时不绘制
+    void renderOverlay(Overlay overlay);
+
+    // 生成层级后顶点或图元被修改时层级失效, 只绘制原模型
+    inline bool lodsValid() const { return !lods_.empty() && lods_revision_ == revision_; }
+
+    // 当前绘制的层级, 0为原模型, 由RenderVisitor按屏幕大小选择
+    inline void lod(unsigned int level) { lod_ = level; }
+    inline unsigned int lod() const { return lod_; }
+
+    // level为0或层级无效时返回自身
+    Geometry& lodGeometry(unsigned int level);
+
+    inline void residency(Residency residency) { residency_ = residency; }
+    inline Residency residency() const { return residency_; }
+
+    // 数据是否在内存中
+    inline bool resident() const { return !released_bytes_; }
+
+    // 从GL缓冲读回释放的数据, 分析和导出前调用; 需要当前GL上下文
+    bool restore() const;
+
+    inline std::size_t releasedBytes() const { return released_bytes_; }
+
+    // 所有geometry当前释放的内存字节数
+    static std::size_t totalReleasedBytes();
+
     virtual void render();
 
+    // 顶点着色器取对象变换的方式, technique按它选择program的变体
+    virtual ProgramVariant programVariant() const { return ProgramVariant::DEFAULT; }
+
+    // technique绑定program之后调用, 设置变体需要的uniform和纹理
+    virtual void bindVariant(Program&) {}
+
+    // 已经绘制过且缓冲全部上传; 分帧上传期间render()不绘制, 结果不应缓存
+    inline bool uploaded() const { return !dirty_ && vertex_array_object_->ready(); }
+
+    // 顶点颜色或纹理带有透明度, 上传时计算, 数据释放后依然有效
+    inline bool translucent() const { return translucent_; }
+
   protected:  
-    void computeBounding();
+    virtual void computeBounding();
+
+    // 在纹理和VAO绑定之后调用, 提交所有图元
+    virtual void drawPrimitives();
+
+    // 模型空间的包围盒, 数据释放后使用释放前记录的值
+    BoundingBox localBox() const;
 
   private:
     void dirtyGLObjects();
     void setupGLObjects();
 
+    void releaseData();
+
   protected:
     std::string name_;
     NodeWeakPtr parent_;
     glm::mat4 mv_;
     bool dirty_;
+    unsigned int revision_;
     std::string uuid_;
 
     Vec3ArrayPtr vertex_array_;
     Vec3ArrayPtr normal_array_;
     Vec4ArrayPtr color_array_;
     Vec2ArrayPtr texcoord_array_;
+    AttribArrayMap attrib_arrays_;
 
     std::vector<PrimitiveSetPtr> primitive_sets_;
     TextureMap textures_;
@@ -139,9 +276,32 @@ namespace Dental {
     RenderTechniquePtr render_technique_;
 
     GLObjectPtrs gl_objects_;
+    GLObjectPtrs draw_objects_;
+    GLVertexArrayObjectPtr vertex_array_object_;
+    GLElementBufferObjectPtr element_buffer_;
     
     BoundingSphere bounding_sphere_;
+    BoundingBox bounding_box_;
     bool dirty_bounding_;
+
+    bool translucent_;
+
+    Residency residency_;
+    mutable std::size_t released_bytes_;
+    BoundingBox released_box_;
+
+    Clusters clusters_;
+    bool cluster_culling_;
+    // 合并后的可见索引区间[first, first + count)
+    std::vector<std::pair<unsigned int, unsigned int>> visible_ranges_;
+
+    std::vector<GeometryPtr> lods_;
+    std::vector<unsigned int> lod_triangles_;
+    unsigned int lods_revision_;
+    unsigned int lod_;
+
+    std::array<PrimitiveSetPtr, OVERLAY_COUNT> overlays_;
+    unsigned int overlays_revision_;
   };
 }
 #endif
\ No newline at end of file
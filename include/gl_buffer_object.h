@@ -0,0 +1,88 @@
+#ifndef __GL_BUFFER_OBJECT_H__
+#define __GL_BUFFER_OBJECT_H__
+
+#include <vector>
+#include <utility>
+#include <glad/glad.h>
+#include <gl_object.h>
+
+namespace Dental {
+  class GLBufferObject : public GLObject {
+  public:
+    GLBufferObject(GLenum target, short data_type_size);
+    ~GLBufferObject() override { release(); }
+
+    GLBufferObject& operator = (GLBufferObject&&) noexcept = delete;
+    GLBufferObject& operator = (const GLBufferObject&) = delete;
+    GLBufferObject(const GLBufferObject&) = delete;
+    GLBufferObject(GLBufferObject&&) noexcept = delete;
+
+    // data_size为元素个数
+    void bindData(GLsizeiptr data_size, void* data);
+
+    // 标记[first, first + count)元素需要更新, 下次bind时用glBufferSubData上传
+    void dirtyRange(GLsizeiptr first, GLsizeiptr count);
+
+    // 绑定缓冲并上传未提交的数据, 不设置顶点属性也不绘制
+    void sync();
+
+    // 是否有数据需要上传
+    inline bool pending() const {
+      return data_size_ && (!buffer_ || dirty_ || buffer_size_ != data_size_ || streamed_ < buffer_size_ || !ranges_.empty());
+    }
+
+    // 缓冲已分配但数据还没有全部上传, 受UploadScheduler的每帧预算限制
+    inline bool streaming() const {
+      return data_size_ && buffer_ && streamed_ < buffer_size_;
+    }
+
+    virtual void bind() override;
+
+    virtual void unbind() override;
+
+    virtual void release() override;
+
+    virtual void dirty() override;
+
+    virtual bool valid() override;
+
+    // 丢弃内存中的数据指针, 保留元素个数和GL缓冲
+    inline void releaseData() { data_ = nullptr; }
+
+    // 从GL缓冲读回全部数据到data, 需要data_size * data_type_size字节
+    bool read(void* data) const;
+
+    inline GLsizeiptr dataSize() const { return data_size_; }
+
+    // 为false时不受每帧上传预算限制, 如每帧都要完整可用的uniform缓冲
+    inline void scheduled(bool scheduled) { scheduled_ = scheduled; }
+    inline bool scheduled() const { return scheduled_; }
+
+    inline unsigned int id() const { return buffer_; }
+    inline GLenum usage() const { return usage_; }
+
+  protected:
+    void upload();
+
+    void stream();
+
+    GLenum target_;
+    short data_type_size_;
+
+    unsigned int buffer_;
+    GLsizeiptr buffer_size_;
+    GLsizeiptr streamed_;
+    GLsizeiptr data_size_;
+    void* data_;
+    bool dirty_;
+
+    bool scheduled_;
+
+    GLenum usage_;
+    unsigned int partial_uploads_;
+    std::vector<std::pair<GLsizeiptr, GLsizeiptr>> ranges_;
+  };
+
+  using GLBufferObjectPtr = std::shared_ptr<GLBufferObject>;
+}
+#endif
@@ -0,0 +1,53 @@
+#ifndef __GL_DELETE_QUEUE_H__
+#define __GL_DELETE_QUEUE_H__
+
+#include <array>
+#include <mutex>
+#include <vector>
+#include <glad/glad.h>
+
+namespace Dental {
+  // 任意线程释放的GL对象先记录下来, 由GL线程在每帧固定位置统一删除
+  class GLDeleteQueue {
+  public:
+    enum class Type {
+      BUFFER,
+      VERTEX_ARRAY,
+      TEXTURE,
+      FRAMEBUFFER,
+      RENDERBUFFER,
+      PROGRAM,
+      COUNT
+    };
+
+    ~GLDeleteQueue() {}
+
+    GLDeleteQueue& operator = (GLDeleteQueue&&) noexcept = delete;
+    GLDeleteQueue& operator = (const GLDeleteQueue&) = delete;
+    GLDeleteQueue(const GLDeleteQueue&) = delete;
+    GLDeleteQueue(GLDeleteQueue&&) noexcept = delete;
+
+    static GLDeleteQueue& instance();
+
+    // 线程安全, 不调用GL
+    void push(Type type, unsigned int name);
+
+    // 只能在GL线程调用, 删除所有记录的对象并通知GLState
+    void flush();
+
+    std::size_t size() const;
+
+    // 上次flush删除的对象个数
+    inline std::size_t deleted() const { return deleted_; }
+
+  private:
+    GLDeleteQueue();
+
+    using Names = std::array<std::vector<GLuint>, static_cast<std::size_t>(Type::COUNT)>;
+
+    mutable std::mutex mutex_;
+    Names names_;
+    std::size_t deleted_;
+  };
+}
+#endif
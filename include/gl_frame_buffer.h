@@ -40,6 +40,14 @@ namespace Dental {
       unsigned int width, unsigned int height,
       unsigned int color_attachment = 0) const;
 
+    // 拷贝src区域到默认帧缓冲的目标区域, 尺寸不同时颜色线性插值
+    void blit(
+      int src_x, int src_y,
+      unsigned int src_width, unsigned int src_height,
+      int x, int y,
+      unsigned int width, unsigned int height,
+      unsigned int color_attachment = 0) const;
+
   protected:
     bool dirty_;
     unsigned int width_;
@@ -0,0 +1,92 @@
+#ifndef __GL_STATE_H__
+#define __GL_STATE_H__
+
+#include <map>
+#include <vector>
+#include <unordered_map>
+#include <glm/vec4.hpp>
+#include <glad/glad.h>
+
+namespace Dental {
+  // 记录当前GL绑定和开关状态, 跳过与当前状态相同的调用
+  class GLState {
+  public:
+    struct Statistics {
+      unsigned int calls;
+      unsigned int skipped;
+    };
+
+    ~GLState() {}
+
+    GLState& operator = (GLState&&) noexcept = delete;
+    GLState& operator = (const GLState&) = delete;
+    GLState(const GLState&) = delete;
+    GLState(GLState&&) noexcept = delete;
+
+    static GLState& instance();
+
+    // 绕过GLState修改了状态后调用, 所有记录变为未知
+    void invalidate();
+
+    void useProgram(unsigned int program);
+
+    void bindVertexArray(unsigned int vertex_array);
+
+    void bindBuffer(GLenum target, unsigned int buffer);
+    void bindBufferBase(GLenum target, unsigned int index, unsigned int buffer);
+
+    void activeTexture(unsigned int unit);
+
+    // 绑定到当前激活的纹理单元
+    void bindTexture(unsigned int texture);
+    // 同时把unit设为激活的纹理单元
+    void bindTexture(unsigned int unit, unsigned int texture);
+
+    void bindFramebuffer(GLenum target, unsigned int framebuffer);
+
+    // 当前绘制的帧缓冲, 状态未知时从GL查询
+    unsigned int drawFramebuffer();
+
+    void viewport(int x, int y, int width, int height);
+
+    void enable(GLenum capability);
+    void disable(GLenum capability);
+
+    void blendFunc(GLenum src, GLenum dst);
+
+    // 删除对象后调用, GL会自动解除已删除对象的绑定
+    void forgetProgram(unsigned int program);
+    void forgetVertexArray(unsigned int vertex_array);
+    void forgetBuffer(unsigned int buffer);
+    void forgetTexture(unsigned int texture);
+    void forgetFramebuffer(unsigned int framebuffer);
+
+    inline const Statistics& statistics() const { return statistics_; }
+    void resetStatistics();
+
+  private:
+    GLState();
+
+    bool skip(bool same);
+
+    unsigned int program_;
+    unsigned int vertex_array_;
+    unsigned int active_texture_;
+    unsigned int read_framebuffer_;
+    unsigned int draw_framebuffer_;
+
+    std::unordered_map<GLenum, unsigned int> buffers_;
+    std::map<std::pair<GLenum, unsigned int>, unsigned int> indexed_buffers_;
+    std::vector<unsigned int> textures_;
+
+    glm::ivec4 viewport_;
+    bool viewport_valid_;
+
+    std::unordered_map<GLenum, bool> capabilities_;
+    GLenum blend_src_;
+    GLenum blend_dst_;
+
+    Statistics statistics_;
+  };
+}
+#endif
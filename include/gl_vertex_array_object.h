@@ -0,0 +1,54 @@
+#ifndef __GL_VERTEX_ARRAY_OBJECT_H__
+#define __GL_VERTEX_ARRAY_OBJECT_H__
+
+#include <vector>
+#include <glad/glad.h>
+#include <gl_buffer_object.h>
+
+namespace Dental {
+  // 记录顶点属性和索引缓冲的绑定状态, 结构改变时才重新设置
+  class GLVertexArrayObject : public GLObject {
+  public:
+    GLVertexArrayObject();
+    ~GLVertexArrayObject() override { release(); }
+
+    GLVertexArrayObject& operator = (GLVertexArrayObject&&) noexcept = delete;
+    GLVertexArrayObject& operator = (const GLVertexArrayObject&) = delete;
+    GLVertexArrayObject(const GLVertexArrayObject&) = delete;
+    GLVertexArrayObject(GLVertexArrayObject&&) noexcept = delete;
+
+    void addArray(const GLBufferObjectPtr& array);
+
+    void elements(const GLBufferObjectPtr& elements);
+    inline const GLBufferObjectPtr& elements() const { return elements_; }
+
+    void clear();
+
+    virtual void bind() override;
+
+    virtual void unbind() override;
+
+    virtual void release() override;
+
+    virtual void dirty() override;
+
+    virtual bool valid() override;
+
+    // 所有缓冲都已上传完, 可以绘制
+    bool ready() const;
+
+    inline unsigned int id() const { return vao_; }
+
+  private:
+    void build();
+
+    unsigned int vao_;
+    bool dirty_;
+
+    std::vector<GLBufferObjectPtr> arrays_;
+    GLBufferObjectPtr elements_;
+  };
+
+  using GLVertexArrayObjectPtr = std::shared_ptr<GLVertexArrayObject>;
+}
+#endif
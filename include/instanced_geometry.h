@@ -0,0 +1,54 @@
+#ifndef __INSTANCED_GEOMETRY_H__
+#define __INSTANCED_GEOMETRY_H__
+
+#include <geometry.h>
+
+namespace Dental {
+  class InstancedGeometry;
+  using InstancedGeometryPtr = std::shared_ptr<InstancedGeometry>;
+
+  // 共享源geometry的顶点和索引缓冲, 一次绘制多个带独立变换和颜色的实例;
+  // technique按ProgramVariant::INSTANCED从实例属性读取变换和颜色
+  class InstancedGeometry : public Geometry {
+  public:
+    explicit InstancedGeometry(const GeometryPtr& source);
+    ~InstancedGeometry() override {}
+
+    Mate_Geometry(Dental, InstancedGeometry)
+
+    InstancedGeometry& operator = (const InstancedGeometry&) = delete;
+    InstancedGeometry& operator = (InstancedGeometry&&) noexcept = delete;
+    InstancedGeometry(const InstancedGeometry&) = delete;
+    InstancedGeometry(InstancedGeometry&&) noexcept = delete;
+
+    inline const GeometryPtr& source() const { return source_; }
+
+    // 返回实例编号
+    unsigned int addInstance(const glm::mat4& transform, const glm::vec4& color = glm::vec4(1.f));
+    void removeInstance(unsigned int index);
+    void clearInstances();
+
+    inline unsigned int numInstances() const { return (unsigned int)transform_array_->size(); }
+
+    // 只更新对应实例的元素
+    void transform(unsigned int index, const glm::mat4& transform);
+    inline const glm::mat4& transform(unsigned int index) const { return (*transform_array_)[index]; }
+
+    void color(unsigned int index, const glm::vec4& color);
+    inline const glm::vec4& color(unsigned int index) const { return (*instance_color_array_)[index]; }
+
+    ProgramVariant programVariant() const override { return ProgramVariant::INSTANCED; }
+
+  protected:
+    void computeBounding() override;
+
+    void drawPrimitives() override;
+
+  private:
+    GeometryPtr source_;
+
+    Mat4ArrayPtr transform_array_;
+    Vec4ArrayPtr instance_color_array_;
+  };
+}
+#endif
@@ -0,0 +1,70 @@
+#ifndef __LOD_GENERATOR_H__
+#define __LOD_GENERATOR_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <geometry.h>
+
+namespace Dental {
+  // 在后台线程用vcg的二次误差边折叠生成简化层级, 由GL线程每帧取回并设置到geometry
+  class LodGenerator {
+  public:
+    // 每一层的三角形数为上一层的1/4
+    static const unsigned int MAX_LEVELS = 3;
+
+    // 三角形少于该值的层级不再生成
+    static const unsigned int MIN_TRIANGLES = 2000;
+
+    ~LodGenerator();
+
+    LodGenerator& operator = (LodGenerator&&) noexcept = delete;
+    LodGenerator& operator = (const LodGenerator&) = delete;
+    LodGenerator(const LodGenerator&) = delete;
+    LodGenerator(LodGenerator&&) noexcept = delete;
+
+    static LodGenerator& instance();
+
+    // 复制geometry的顶点, 颜色和三角形后排队简化; 有纹理坐标, 标量或三角形太少时返回false
+    bool request(const GeometryPtr& geometry);
+
+    // 是否有已完成的结果等待frame()取回
+    bool ready() const;
+
+    // 每帧在GL线程调用, 返回本次设置了层级的geometry个数;
+    // 简化期间geometry被修改时结果作废
+    unsigned int frame();
+
+  private:
+    LodGenerator();
+
+    struct Level {
+      std::vector<glm::vec3> vertices;
+      std::vector<glm::vec4> colors;
+      std::vector<unsigned int> indices;
+    };
+
+    struct Job {
+      std::weak_ptr<Geometry> geometry;
+      unsigned int revision;
+      unsigned int triangles;
+      Level source;
+      std::vector<Level> levels;
+    };
+
+    void run();
+
+    void simplify(Job& job);
+
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<Job> pending_;
+    std::vector<Job> finished_;
+    std::atomic<bool> stop_;
+    std::thread thread_;
+  };
+}
+#endif
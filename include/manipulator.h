@@ -86,6 +86,9 @@ namespace Dental {
 
     bool handleEvent(Event& event);
 
+    // 是否在拖动或飞行中
+    bool moving();
+
     Viewpoint createViewpoint(BoundingSphere& sphere);
     Viewpoint viewpoint();
     void viewpoint(Viewpoint& viewpoint, float duration_s = 0.0);
@@ -0,0 +1,79 @@
+#ifndef __MESH_OPTIMIZER_H__
+#define __MESH_OPTIMIZER_H__
+
+#include <vector>
+#include <geometry.h>
+
+namespace Dental::MeshOptimizer {
+  struct CacheStatistics {
+    // average cache miss ratio, post-transform vertex cache misses per triangle
+    float acmr_before;
+    float acmr_after;
+  };
+
+  struct FetchStatistics {
+    // 实际读取的字节数/被引用顶点的字节数, 1.0为理想值
+    float overfetch_before;
+    float overfetch_after;
+  };
+
+  struct Edges {
+    // LINES模式的索引, 每两个一条边; 位置相同的顶点合并后以最小的编号表示
+    std::vector<unsigned int> unique;
+    std::vector<unsigned int> boundary;
+    std::vector<unsigned int> crease;
+    // 被超过两个三角形共享的边, 同时计入boundary
+    unsigned int non_manifold;
+  };
+
+  struct EdgeStatistics {
+    unsigned int edges;
+    unsigned int boundary_edges;
+    unsigned int crease_edges;
+    unsigned int non_manifold_edges;
+    float milliseconds;
+  };
+
+  // 导入时三角形不少于该值才分簇, 小模型逐簇裁剪省下的绘制抵不过多出的绘制调用
+  constexpr unsigned int MIN_CLUSTERED_TRIANGLES = 65536;
+
+  // 判定折边的两侧面法向夹角, 单位为度
+  constexpr float DEFAULT_CREASE_ANGLE = 30.f;
+
+  // 模拟FIFO顶点缓存, 计算三角形索引的ACMR
+  float computeACMR(const std::vector<unsigned int>& indices, unsigned int cache_size = 16);
+
+  // Tipsify三角形重排(Sander 2007), 只改变三角形顺序, 不改变顶点
+  void optimizeVertexCache(std::vector<unsigned int>& indices, unsigned int vertex_count, unsigned int cache_size = 16);
+
+  // 对geometry中所有TRIANGLES模式的DrawElementsUInt做重排
+  CacheStatistics optimizeVertexCache(Geometry& geometry, unsigned int cache_size = 16);
+
+  // 模拟顶点缓存和64字节的读取缓存行, 计算一个stride大小的顶点流的overfetch
+  float computeOverfetch(const std::vector<unsigned int>& indices, unsigned int vertex_count, unsigned int vertex_size);
+
+  // 按索引中首次使用的顺序重新编号顶点, 返回旧编号到新编号的映射
+  std::vector<unsigned int> optimizeVertexFetchRemap(const std::vector<unsigned int>& indices, unsigned int vertex_count);
+
+  // 重排geometry的四个顶点属性数组并改写所有DrawElementsUInt, 应在optimizeVertexCache之后调用
+  FetchStatistics optimizeVertexFetch(Geometry& geometry);
+
+  // 把第一个图元的三角形按空间位置划分为不超过max_triangles个三角形的簇并重排索引,
+  // 计算每个簇的包围球和法向锥, 返回簇的个数; 应在optimizeVertexCache之后调用
+  unsigned int buildClusters(Geometry& geometry, unsigned int max_triangles = 4096);
+
+  // 按无向边哈希分组提取三角形的边, 多线程并行; 先按位置合并顶点, STL读入的三角形不共享顶点也能找到相邻面
+  Edges extractEdges(const std::vector<unsigned int>& indices, const std::vector<glm::vec3>& vertices,
+                     float crease_angle = DEFAULT_CREASE_ANGLE);
+
+  // 提取geometry中所有TRIANGLES模式的DrawElementsUInt的边, 设置为Geometry::Overlay的三个LINES叠加图元
+  EdgeStatistics extractEdges(Geometry& geometry, float crease_angle = DEFAULT_CREASE_ANGLE);
+
+  // 按图元顺序拼接geometry中所有TRIANGLES模式的DrawElementsUInt的索引
+  std::vector<unsigned int> collectTriangles(const Geometry& geometry);
+
+  // 把提取的边设置为geometry的叠加图元, 索引从edges中移走; 没有边时也设置空的图元
+  void setOverlays(Geometry& geometry, Edges& edges);
+}
+
+#endif
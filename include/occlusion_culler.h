@@ -0,0 +1,71 @@
+#ifndef __OCCLUSION_CULLER_H__
+#define __OCCLUSION_CULLER_H__
+
+#include <vector>
+#include <glm/mat4x4.hpp>
+#include <bounding_box.h>
+#include <render_queue.h>
+
+namespace Dental {
+  // CPU上的低分辨率深度缓冲, 每次提交前绘制几个屏幕上最大的遮挡体,
+  // 再用最大深度金字塔测试其他geometry的包围盒, 完全被挡住的不再绘制
+  class OcclusionCuller {
+  public:
+    // 深度缓冲的宽度, 高度按视口比例
+    static const unsigned int WIDTH = 256;
+
+    // 每次最多绘制的遮挡体个数
+    static const unsigned int MAX_OCCLUDERS = 4;
+
+    // 遮挡体超过该三角形数时改用不超过它的简化层级, 没有时不作为遮挡体
+    static const unsigned int MAX_OCCLUDER_TRIANGLES = 8192;
+
+    OcclusionCuller();
+    ~OcclusionCuller();
+
+    OcclusionCuller& operator = (OcclusionCuller&&) noexcept = delete;
+    OcclusionCuller& operator = (const OcclusionCuller&) = delete;
+    OcclusionCuller(const OcclusionCuller&) = delete;
+    OcclusionCuller(OcclusionCuller&&) noexcept = delete;
+
+    // 选出遮挡体并移除被挡住的项, 返回移除的geometry个数, 不含额外的项
+    unsigned int apply(std::vector<RenderQueue::Item>& items);
+
+    // 清空深度缓冲, 之后可以绘制遮挡体
+    void clear(const Viewport& viewport);
+
+    // 逆时针和顺时针的三角形都绘制, 扫描得到的牙龈通常不封闭; 只写入被完全覆盖的像素
+    // neighbors的第3i+j项为三角形i对着第j个顶点的边另一侧的三角形, 为空时每条边都按轮廓收缩
+    void rasterize(const std::vector<glm::vec3>& vertices, const std::vector<unsigned int>& indices, const glm::mat4& mvp,
+                   const std::vector<unsigned int>& neighbors = {});
+
+    // 绘制完遮挡体后调用, 生成最大深度金字塔
+    void buildHierarchy();
+
+    // box位于mvp的模型空间, 跨过近平面或无效时按可见处理
+    bool visible(const BoundingBox& box, const glm::mat4& mvp) const;
+
+  private:
+    struct Occluder {
+      std::weak_ptr<Geometry> geometry;
+      unsigned int revision;
+      std::vector<glm::vec3> vertices;
+      std::vector<unsigned int> indices;
+      std::vector<unsigned int> neighbors;
+    };
+
+    const Occluder* occluder(const GeometryPtr& geometry);
+
+    struct Level {
+      unsigned int width;
+      unsigned int height;
+      std::vector<float> depth;
+    };
+
+    // 第0层为深度缓冲, 之后每层宽高减半, 存储覆盖区域中最远的深度
+    std::vector<Level> levels_;
+
+    std::vector<Occluder> occluders_;
+  };
+}
+#endif
@@ -5,6 +5,7 @@
 #include <memory>
 #include <glad/glad.h>
 #include <gl_object.h>
+#include <gl_buffer_object.h>
 
 namespace Dental {
   class PrimitiveSet;
@@ -63,10 +64,20 @@ namespace Dental {
 
     virtual void dirty() = 0;
 
+    // 上传后释放内存中的索引, 返回释放的字节数
+    virtual std::size_t releaseData() { return 0; }
+
+    // 从GL缓冲读回释放的索引
+    virtual bool restoreData() { return true; }
+
     virtual PrimitiveSetPtr clone() = 0;
 
     virtual GLObjectPtr GLObject() const = 0;
 
+    // 所有图元累计提交的glDraw*调用次数
+    static unsigned int drawCalls();
+    static void resetStatistics();
+
   protected:
     Type primitive_type_;
     Mode mode_;
@@ -88,6 +99,8 @@ namespace Dental {
 
     virtual void bind() override;
 
+    void drawInstanced(GLsizei instances);
+
     virtual void unbind() override {}
 
     virtual void release() override {}
@@ -174,10 +187,10 @@ namespace Dental {
 
   using DrawArraysPtr = std::shared_ptr<DrawArrays>;
 
-  class GLElementBufferObject : public GLObject {
+  class GLElementBufferObject : public GLBufferObject {
   public:
     GLElementBufferObject(short data_type_size, unsigned long gl_data_type);
-    ~GLElementBufferObject() override { release(); }
+    ~GLElementBufferObject() override {}
 
     GLElementBufferObject& operator = (GLElementBufferObject&&) noexcept = delete;
     GLElementBufferObject& operator = (const GLElementBufferObject&) = delete;
@@ -188,25 +201,17 @@ namespace Dental {
 
     virtual void bind() override;
 
-    virtual void unbind() override;
+    // 只绘制, 索引缓冲需已绑定(如记录在VAO中); 未上传完时不绘制
+    void draw();
 
-    virtual void release() override;
+    // 绘制[first, first + count)的索引
+    void draw(GLsizei first, GLsizei count);
 
-    virtual void dirty() override;
-
-    virtual bool valid() override;
+    void drawInstanced(GLsizei instances);
 
   private:
-    struct Profile {
-      short data_type_size;
-      unsigned long gl_data_type;
-    } profile_;
-
+    unsigned long gl_data_type_;
     GLenum mode_;
-    unsigned int ebo_;
-    GLsizei data_size_;
-    void* data_;
-    bool dirty_;
   };
 
   using GLElementBufferObjectPtr = std::shared_ptr<GLElementBufferObject>;
@@ -246,8 +251,9 @@ namespace Dental {
 
     inline void clear() { std::vector<TYPE>::clear(); }
 
+    // 包括已释放到GL缓冲中的索引
     inline virtual unsigned int numIndices() const override {
-      return static_cast<unsigned int>(vector_type::size());
+      return static_cast<unsigned int>(vector_type::empty() ? gl_object_->dataSize() : vector_type::size());
     }
 
     inline virtual void reversePrimitives(unsigned int size) override {
@@ -275,6 +281,33 @@ namespace Dental {
       gl_object_->dirty();
     }
 
+    // 只更新[first, first + count)的索引
+    inline void dirty(std::size_t first, std::size_t count) {
+      bind();
+      gl_object_->dirtyRange(first, count);
+    }
+
+    std::size_t releaseData() override {
+      auto bytes = vector_type::capacity() * sizeof(TYPE);
+      vector_type().swap(*this);
+      gl_object_->releaseData();
+      return bytes;
+    }
+
+    bool restoreData() override {
+      if (!vector_type::empty() || !gl_object_->dataSize()) {
+        return true;
+      }
+
+      vector_type::resize(gl_object_->dataSize());
+      if (!gl_object_->read(vector_type::data())) {
+        vector_type().swap(*this);
+        return false;
+      }
+      gl_object_->bindData(vector_type::size(), vector_type::data());
+      return true;
+    }
+
     virtual PrimitiveSetPtr clone() override {
       std::shared_ptr<DrawElements> elements = std::make_shared<DrawElements<TYPE, GLTYPE>>();
       elements->mode_ = mode_;
@@ -2,6 +2,7 @@
 #define __PROGRAM_H__
 
 #include <string>
+#include <vector>
 #include <unordered_map>
 #include <glm/ext.hpp>
 #include <uniform.h>
@@ -10,6 +11,23 @@
 namespace Dental {
   class Program : public GLObject {
   public:
+    struct UniformInfo {
+      int location;
+      unsigned int type;
+      int size;
+      // 最后一次上传的值, 为空表示还未上传
+      std::vector<unsigned char> value;
+    };
+
+    struct AttribInfo {
+      int location;
+      unsigned int type;
+      int size;
+    };
+
+    using UniformTable = std::unordered_map<std::string, UniformInfo>;
+    using AttribTable = std::unordered_map<std::string, AttribInfo>;
+
     Program(
       const std::string& vertex_source,
       const std::string& fragment_source);
@@ -21,8 +39,21 @@ namespace Dental {
     Program(const Program&) = delete;
     Program(Program&&) noexcept = delete;
 
-    int attrib_location(const std::string& name);
-    int uniform_location(const std::string& name);
+    int attrib_location(const std::string& name) const;
+    int uniform_location(const std::string& name) const;
+
+    inline const UniformTable& uniforms() const { return uniforms_; }
+    inline const AttribTable& attribs() const { return attribs_; }
+
+    // 值与上次上传的相同时跳过, 程序需已bind
+    void uniform(const std::string& name, int value);
+    void uniform(const std::string& name, float value);
+    void uniform(const std::string& name, const glm::vec2& value);
+    void uniform(const std::string& name, const glm::vec3& value);
+    void uniform(const std::string& name, const glm::vec4& value);
+    void uniform(const std::string& name, const glm::mat3& value);
+    void uniform(const std::string& name, const glm::mat4& value);
+    void uniform(const Uniform& uniform);
 
     void bind(const glm::mat4& mv, const glm::mat4& mvp);
 
@@ -36,11 +67,22 @@ namespace Dental {
 
     virtual bool valid() override;
 
+    // 因值未改变而跳过的glUniform调用次数
+    static unsigned int skippedUploads();
+    static void resetStatistics();
+
   protected:
     void create();
+    void reflect();
+
+    // 返回需要上传的uniform, 不存在或值未改变时返回nullptr
+    UniformInfo* update(const std::string& name, const void* data, unsigned int size);
 
     unsigned int program_;
 
+    UniformTable uniforms_;
+    AttribTable attribs_;
+
     bool dirty_;
     std::string vertex_source_;
     std::string fragment_source_;
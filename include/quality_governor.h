@@ -0,0 +1,78 @@
+#ifndef __QUALITY_GOVERNOR_H__
+#define __QUALITY_GOVERNOR_H__
+
+#include <viewport.h>
+
+namespace Dental {
+  // 根据相机是否在交互中决定绘制质量: 拖动或飞行期间降低分辨率, 不画阴影,
+  // 停止后的下一帧恢复完整质量; 交互期间的分辨率按实测帧时间调整
+  class QualityGovernor {
+  public:
+    // 关闭动态分辨率时交互期间的分辨率比例
+    static constexpr float INTERACTIVE_SCALE = 0.5f;
+
+    // 动态分辨率每次调整的步长
+    static constexpr float SCALE_STEP = 0.05f;
+
+    // 两次调整之间至少间隔的交互帧数
+    static const unsigned int ADJUST_INTERVAL = 10;
+
+    QualityGovernor();
+    ~QualityGovernor();
+
+    QualityGovernor& operator = (QualityGovernor&&) noexcept = delete;
+    QualityGovernor& operator = (const QualityGovernor&) = delete;
+    QualityGovernor(const QualityGovernor&) = delete;
+    QualityGovernor(QualityGovernor&&) noexcept = delete;
+
+    // 关闭后始终以完整质量绘制
+    inline void enabled(bool enabled) { enabled_ = enabled; }
+    inline bool enabled() const { return enabled_; }
+
+    // 交互期间按帧时间调整分辨率, 关闭时使用INTERACTIVE_SCALE
+    void dynamicResolution(bool dynamic_resolution);
+    inline bool dynamicResolution() const { return dynamic_resolution_; }
+
+    // 目标帧时间, 单位秒
+    inline void targetFrameTime(float seconds) { target_frame_time_ = seconds; }
+    inline float targetFrameTime() const { return target_frame_time_; }
+
+    // 动态分辨率的下限, (0, 1]
+    void minScale(float scale);
+    inline float minScale() const { return min_scale_; }
+
+    // 每帧绘制前调用, moving为相机是否在交互中
+    void update(bool moving);
+
+    // 每帧交换缓冲后调用, 只统计交互帧的耗时
+    void frameTime(float seconds);
+
+    // 本帧是否以降低的质量绘制
+    inline bool interactive() const { return interactive_; }
+
+    // 上一帧降低了质量, 还需要再绘制一帧完整质量
+    inline bool pending() const { return interactive_; }
+
+    // 本帧的分辨率比例
+    float resolutionScale() const;
+
+    // 交互期间平滑后的帧时间
+    inline float averageFrameTime() const { return average_frame_time_; }
+
+    // 按比例缩放视口, 宽高至少为1
+    static Viewport scale(const Viewport& viewport, float scale);
+
+  private:
+    bool enabled_;
+    bool interactive_;
+
+    bool dynamic_resolution_;
+    float target_frame_time_;
+    float min_scale_;
+    float scale_;
+
+    float average_frame_time_;
+    unsigned int frames_since_adjust_;
+  };
+}
+#endif
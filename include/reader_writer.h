@@ -17,17 +17,45 @@ namespace Dental::ReaderWriter {
   };
 
 	using Options = std::unordered_map<std::string, std::string>;
-  class WriteOptions : public Options {
+  //ReadOptions和WriteOptions共用的存取, 开关保存为"1"或"0"
+  class OptionsBase : public Options {
+  public:
+    void option(std::string parma, std::string value);
+
+    std::string option(std::string parma) const;
+
+  protected:
+    void flagOption(const std::string& parma, bool value);
+  };
+
+  class ReadOptions : public OptionsBase {
+  public:
+    //读入后是否重排三角形以优化顶点缓存
+    void optimizeVertexCache(bool flag);
+
+    //读入后是否按索引首次使用的顺序重排顶点
+    void optimizeVertexFetch(bool flag);
+
+    //读入后是否把三角形很多的模型分簇, 绘制时逐簇裁剪
+    void buildClusters(bool flag);
+
+    //读入后是否在后台生成简化层级, 缩小显示时绘制简化的模型
+    void generateLods(bool flag);
+
+    //读入后是否在后台烘焙顶点的环境光遮蔽
+    void bakeAmbientOcclusion(bool flag);
+
+    //上传到GL缓冲后是否释放内存中的数据, 适合只显示的模型
+    void releaseAfterUpload(bool flag);
+  };
+
+  class WriteOptions : public OptionsBase {
   public:
     //是否保存二进制
     void binary(bool flag);
 
     //stl文件是否是彩色模式保存
     void colorMode(bool flag);
-
-    void option(std::string parma, std::string value);
-
-    std::string option(std::string parma) const;
   };
 
   std::tuple<ImagePtr, Status, std::string> readImage(unsigned char* data, std::size_t size);
@@ -36,7 +64,7 @@ namespace Dental::ReaderWriter {
   
   std::tuple<Status, std::string> writeImage(const std::string &file_name, const Image &image);
 
-  std::tuple<GeometryPtr, Status, std::string> read(const std::string &file_name);
+  std::tuple<GeometryPtr, Status, std::string> read(const std::string &file_name, const ReadOptions& options = ReadOptions());
 
   std::tuple<Status, std::string> write(const std::string &file_name, const Geometry& geometry, const WriteOptions& options);
 
@@ -4,6 +4,7 @@
 #include <memory>
 #include <glm/mat4x4.hpp>
 #include <viewport.h>
+#include <frustum.h>
 
 namespace Dental {
   class RenderInfo {
@@ -28,10 +29,23 @@ namespace Dental {
     void viewport(const Viewport& viewport);
     const Viewport& viewport() const;
 
+    // 当前mv的模型空间中的视锥
+    Frustum frustum() const;
+
+    // 相机交互期间以较低的质量绘制, 如不画阴影
+    inline void interactive(bool interactive) { interactive_ = interactive; }
+    inline bool interactive() const { return interactive_; }
+
+    // 有烘焙的顶点遮蔽时用它代替阴影, 包括静止的帧
+    inline void ambientOcclusion(bool ambient_occlusion) { ambient_occlusion_ = ambient_occlusion; }
+    inline bool ambientOcclusion() const { return ambient_occlusion_; }
+
   protected:
     glm::mat4 mv_;
     glm::mat4 projection_;
     Viewport viewport_;
+    bool interactive_;
+    bool ambient_occlusion_;
   };
 
   using RenderInfoPtr = std::shared_ptr<RenderInfo>;
@@ -0,0 +1,79 @@
+#ifndef __RENDER_QUEUE_H__
+#define __RENDER_QUEUE_H__
+
+#include <tuple>
+#include <vector>
+#include <render_info.h>
+#include <geometry.h>
+
+namespace Dental {
+  // 收集一个相机下的绘制, 按状态排序后统一提交
+  class RenderQueue {
+  public:
+    struct Key {
+      unsigned int target;
+      // 开启混合时半透明的排在不透明之后, 彼此保持场景顺序
+      bool blended;
+      const Program* program;
+      const Texture* texture;
+      const RenderTechnique* technique;
+
+      inline bool operator < (const Key& rhs) const {
+        if (target != rhs.target || blended != rhs.blended) {
+          return std::tie(target, blended) < std::tie(rhs.target, rhs.blended);
+        }
+        if (blended) {
+          return false;
+        }
+        return std::tie(program, texture, technique) <
+          std::tie(rhs.program, rhs.texture, rhs.technique);
+      }
+    };
+
+    struct Item {
+      Key key;
+      RenderInfo info;
+      GeometryPtr geometry;
+      RenderTechniquePtr technique;
+      // 用geometry自身之外的technique额外绘制, 同一geometry已有自己的项
+      bool extra;
+    };
+
+    // 提交的项数, 一项可能有多次绘制调用, 见PrimitiveSet::drawCalls()
+    struct Statistics {
+      unsigned int items;
+      unsigned int program_changes;
+      unsigned int texture_changes;
+    };
+
+    RenderQueue();
+    ~RenderQueue();
+
+    RenderQueue& operator = (RenderQueue&&) noexcept = delete;
+    RenderQueue& operator = (const RenderQueue&) = delete;
+    RenderQueue(const RenderQueue&) = delete;
+    RenderQueue(RenderQueue&&) noexcept = delete;
+
+    void push(unsigned int target, const RenderInfo& info, Geometry& geometry);
+
+    // 用geometry自身之外的technique额外绘制一次, 如叠加的边
+    void push(unsigned int target, const RenderInfo& info, Geometry& geometry, const RenderTechniquePtr& technique);
+
+    // 排序并提交所有绘制, 之后队列为空
+    void flush();
+
+    inline bool empty() const { return items_.empty(); }
+    inline std::size_t size() const { return items_.size(); }
+
+    // 提交前可以移除不需要绘制的项, 如被遮挡的geometry
+    inline std::vector<Item>& items() { return items_; }
+
+    // 所有队列累计的提交统计
+    static const Statistics& statistics();
+    static void resetStatistics();
+
+  private:
+    std::vector<Item> items_;
+  };
+}
+#endif
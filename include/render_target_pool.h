@@ -0,0 +1,56 @@
+#ifndef __RENDER_TARGET_POOL_H__
+#define __RENDER_TARGET_POOL_H__
+
+#include <vector>
+#include <gl_frame_buffer.h>
+
+namespace Dental {
+  // 共享的离屏渲染目标, 使用者在一次绘制期间借用, 用完归还
+  class RenderTargetPool {
+  public:
+    // 超过该帧数没有借用的目标被删除
+    static const unsigned int MAX_IDLE_FRAMES = 120;
+
+    // 同一尺寸最多保留内容的owner个数; 之后的owner借用无主的临时目标, 不抢占已有owner的内容
+    static const unsigned int MAX_TARGETS_PER_SIZE = 4;
+
+    ~RenderTargetPool() {}
+
+    RenderTargetPool& operator = (RenderTargetPool&&) noexcept = delete;
+    RenderTargetPool& operator = (const RenderTargetPool&) = delete;
+    RenderTargetPool(const RenderTargetPool&) = delete;
+    RenderTargetPool(RenderTargetPool&&) noexcept = delete;
+
+    static RenderTargetPool& instance();
+
+    // 返回一个尺寸相同且未被借用的目标, 没有时创建
+    // owner非空时优先返回它上次归还的目标, 此时kept为true, 内容可以直接使用;
+    // 拥有目标的owner已达MAX_TARGETS_PER_SIZE时返回临时目标, kept总是false
+    GLFrameTextureBufferPtr acquire(unsigned int width, unsigned int height,
+                                    const void* owner = nullptr, bool* kept = nullptr);
+
+    void release(const GLFrameTextureBufferPtr& target);
+
+    // 每帧调用一次, 删除长时间未使用的目标
+    void frame();
+
+    inline std::size_t size() const { return targets_.size(); }
+
+    // 所有目标的显存估算, 深度24+8位和RGBA8颜色各4字节
+    std::size_t memory() const;
+
+  private:
+    RenderTargetPool();
+
+    struct Target {
+      GLFrameTextureBufferPtr buffer;
+      bool borrowed;
+      unsigned int last_frame;
+      const void* owner;
+    };
+
+    std::vector<Target> targets_;
+    unsigned int frame_;
+  };
+}
+#endif
@@ -1,7 +1,9 @@
 #ifndef __RENDER_TECHNIQUE_H__
 #define __RENDER_TECHNIQUE_H__
 
+#include <array>
 #include <memory>
+#include <unordered_set>
 #include <program.h>
 #include <render_info.h>
 #include <gl_frame_buffer.h>
@@ -10,6 +12,20 @@ namespace Dental {
   class RenderInfo;
   class Geometry;
 
+  // 顶点着色器取对象变换的方式, 同一program按geometry的类型选用对应的变体
+  enum class ProgramVariant {
+    DEFAULT = 0,
+    // 对象编号取变换纹理中的一行, 见BatchGeometry
+    BATCH = 1,
+    // 变换和颜色来自实例属性, 见InstancedGeometry
+    INSTANCED = 2
+  };
+
+  static const unsigned int PROGRAM_VARIANT_COUNT = 3;
+
+  // 下标为ProgramVariant
+  using ProgramVariants = std::array<ProgramPtr, PROGRAM_VARIANT_COUNT>;
+
   class ProgramPool : public std::unordered_map<std::string, ProgramPtr> {
   public:
     static ProgramPool& instance();
@@ -18,6 +34,11 @@ namespace Dental {
       const std::string& vertex_source,
       const std::string& fragment_source);
 
+    // name的各个变体, 变体在池中的名字为name加后缀, 如"white_batch"
+    ProgramVariants variants(const std::string& name);
+
+    static std::string variantName(const std::string& name, ProgramVariant variant);
+
   protected:
     ProgramPool();
   };
@@ -32,7 +53,7 @@ namespace Dental {
 
   class RenderTechnique {
   public:
-    using UniformMap = std::unordered_map<UniformPtr, int>;
+    using UniformSet = std::unordered_set<UniformPtr>;
 
     RenderTechnique(const std::string& name);
     virtual ~RenderTechnique();
@@ -51,9 +72,15 @@ namespace Dental {
 
     inline ProgramPtr& program() { return program_; }
 
+    // 绘制geometry时使用的program, 用于渲染队列排序
+    virtual const ProgramPtr& program(const Geometry&) { return program_; }
+
+    // 能否绘制使用该变体的geometry, 如BatchGeometry
+    virtual bool supports(ProgramVariant variant) const { return variant == ProgramVariant::DEFAULT; }
+
     UniformPtr uniform(const std::string& name) const;
 
-    const UniformMap& uniforms() const { return uniforms_; }
+    const UniformSet& uniforms() const { return uniforms_; }
 
     virtual void apply(RenderInfo& info, Geometry& geometry);
 
@@ -62,10 +89,16 @@ namespace Dental {
     void removeUniform(const std::string& name);
     void clearUniform();
 
+    // geometry使用的变体
+    static const ProgramPtr& variant(const ProgramVariants& programs, const Geometry& geometry);
+
+    // 绑定program和矩阵, 并设置geometry的变体需要的uniform
+    static void bind(const ProgramPtr& program, RenderInfo& info, Geometry& geometry);
+
   protected:
     std::string name_;
     std::string uuid_;
-    UniformMap uniforms_;
+    UniformSet uniforms_;
 
     ProgramPtr program_;
   };
@@ -78,7 +111,16 @@ namespace Dental {
 
     Mate_RenderTechnique(DefaultRenderTechnique)
 
+    const ProgramPtr& program(const Geometry& geometry) override;
+
+    bool supports(ProgramVariant) const override { return true; }
+
     void apply(RenderInfo& info, Geometry& geometry) override;
+
+  private:
+    ProgramVariants white_programs_;
+    ProgramVariants color_programs_;
+    ProgramVariants texture_programs_;
   };
 
   using DefaultRenderTechniquePtr = std::shared_ptr<DefaultRenderTechnique>;
@@ -89,15 +131,47 @@ namespace Dental {
 
     Mate_RenderTechnique(ShadowRenderTechnique)
 
+    const ProgramPtr& program(const Geometry& geometry) override { return variant(shadow_programs_, geometry); }
+
+    bool supports(ProgramVariant) const override { return true; }
+
     void apply(RenderInfo& info, Geometry& geometry) override;
 
     glm::mat4& mv() { return mv_; }
 
+    // 阴影图边长, 取不超过视口长边的2的幂, 限制在[MIN_SIZE, MAX_SIZE]
+    static const int MIN_SIZE = 256;
+    static const int MAX_SIZE = 2048;
+    static int shadowMapSize(const Viewport& viewport);
+
+    // 因深度图未变化而跳过的深度绘制次数; 每种尺寸只有RenderTargetPool::MAX_TARGETS_PER_SIZE个
+    // technique能保留深度图, 其余的每次重新绘制
+    static unsigned int skippedDepthPasses();
+    static void resetStatistics();
+
   private:
-    void renderDepth(RenderInfo& info, Geometry& geometry);
+    RenderInfo depthRenderInfo(Geometry& geometry) const;
+
+    void renderDepth(RenderInfo& info, RenderInfo& depth_render_info, Geometry& geometry);
     void renderShadow(RenderInfo& info, Geometry& geometry);
 
-    GLFrameTextureBuffer frambuffer;
+    // 不画深度图和阴影, 用烘焙的遮蔽, 顶点颜色或白色绘制; 相机交互期间,
+    // 或RenderInfo::ambientOcclusion()且已经烘焙时使用
+    void renderPreview(RenderInfo& info, Geometry& geometry);
+
+    // 只在一次apply期间从RenderTargetPool借用, 下次借回同一个时可复用深度图
+    GLFrameTextureBufferPtr frambuffer_;
+
+    // 上次深度图对应的输入
+    const Geometry* depth_geometry_;
+    unsigned int depth_revision_;
+    glm::mat4 depth_mvp_;
+
+    ProgramVariants depth_programs_;
+    ProgramVariants shadow_programs_;
+    ProgramVariants color_programs_;
+    ProgramVariants white_programs_;
+    ProgramVariants occlusion_programs_;
 
     UniformPtr uniform_tex_;
     UniformPtr uniform_mvp_;
@@ -108,5 +182,103 @@ namespace Dental {
   };
 
   using ShadowRenderTechniquePtr = std::shared_ptr<ShadowRenderTechnique>;
+
+  // 把Attrib::SCALAR的标量按范围归一化后查颜色表着色, 用于距离, 厚度等热力图;
+  // 范围和颜色表都是uniform, 修改时不需要重新上传顶点
+  class ScalarRenderTechnique : public RenderTechnique {
+  public:
+    // 颜色表按行存放在同一张纹理中
+    enum class Colormap {
+      RAINBOW = 0,
+      HEAT = 1,
+      COOL_WARM = 2
+    };
+
+    static const unsigned int COLORMAP_COUNT = 3;
+
+    // 每个颜色表的采样数
+    static const unsigned int COLORMAP_SIZE = 256;
+
+    // 颜色表纹理使用的纹理单元
+    static const unsigned int COLORMAP_UNIT = 2;
+
+    ScalarRenderTechnique();
+    ~ScalarRenderTechnique() override;
+
+    Mate_RenderTechnique(ScalarRenderTechnique)
+
+    // 映射到颜色表两端的标量, 范围外的取端点颜色
+    void range(float min, float max);
+    glm::vec2 range() const;
+
+    void colormap(Colormap colormap);
+    Colormap colormap() const;
+
+    void apply(RenderInfo& info, Geometry& geometry) override;
+
+    // 颜色表在[0, 1]处的颜色, 与纹理内容一致
+    static glm::vec4 colormapColor(Colormap colormap, float t);
+
+  private:
+    unsigned int colormapTexture();
+
+    unsigned int colormap_texture_;
+
+    UniformPtr uniform_range_;
+    UniformPtr uniform_colormap_;
+    UniformPtr uniform_texture_;
+  };
+
+  using ScalarRenderTechniquePtr = std::shared_ptr<ScalarRenderTechnique>;
+
+  // 使用AmbientOcclusionBaker烘焙的顶点遮蔽, 单次绘制得到接近接触阴影的深度感
+  class AmbientOcclusionRenderTechnique : public RenderTechnique {
+  public:
+    AmbientOcclusionRenderTechnique();
+
+    Mate_RenderTechnique(AmbientOcclusionRenderTechnique)
+
+    const ProgramPtr& program(const Geometry& geometry) override { return variant(programs_, geometry); }
+
+    bool supports(ProgramVariant) const override { return true; }
+
+    void apply(RenderInfo& info, Geometry& geometry) override;
+
+    // 用programs中geometry的变体绘制, ShadowRenderTechnique的交互预览共用
+    static void render(RenderInfo& info, Geometry& geometry, const ProgramVariants& programs);
+
+  private:
+    ProgramVariants programs_;
+  };
+
+  using AmbientOcclusionRenderTechniquePtr = std::shared_ptr<AmbientOcclusionRenderTechnique>;
+
+  // 在模型上叠加MeshOptimizer::extractEdges提取的边, 由RenderVisitor在geometry自身的technique之外额外提交;
+  // geometry修改后第一次绘制时交给EdgeExtractor在后台重新提取
+  class EdgeRenderTechnique : public RenderTechnique {
+  public:
+    EdgeRenderTechnique();
+
+    Mate_RenderTechnique(EdgeRenderTechnique)
+
+    // 绘制的叠加图元, 第i位对应Geometry::Overlay的第i种
+    inline void overlays(unsigned int mask) { overlays_ = mask; }
+    inline unsigned int overlays() const { return overlays_; }
+
+    const ProgramPtr& program(const Geometry& geometry) override { return variant(programs_, geometry); }
+
+    bool supports(ProgramVariant) const override { return true; }
+
+    void apply(RenderInfo& info, Geometry& geometry) override;
+
+  private:
+    unsigned int overlays_;
+
+    ProgramVariants programs_;
+
+    UniformPtr uniform_color_;
+  };
+
+  using EdgeRenderTechniquePtr = std::shared_ptr<EdgeRenderTechnique>;
 }
 #endif
\ No newline at end of file
@@ -3,11 +3,32 @@
 
 #include <visitor.h>
 #include <render_info.h>
+#include <view_uniform_buffer.h>
+#include <render_queue.h>
+#include <occlusion_culler.h>
 
 namespace Dental {
   class RenderVisitor : public Visitor {
   public:
-    RenderVisitor(RenderInfoPtr& render_info);
+    struct CullStatistics {
+      unsigned int drawn;
+      unsigned int culled;
+      // 分簇geometry中绘制和裁剪的簇
+      unsigned int clusters_drawn;
+      unsigned int clusters_culled;
+      // 被遮挡体完全挡住的geometry
+      unsigned int occluded;
+      // 使用简化层级绘制的geometry
+      unsigned int simplified;
+    };
+
+    // 每个三角形在屏幕上至少占的像素数, 超过时换用更简化的层级
+    static constexpr float LOD_PIXELS_PER_TRIANGLE = 2.f;
+
+    // 层级切换的面积容差, 在阈值附近缩放时不来回切换
+    static constexpr float LOD_HYSTERESIS = 1.25f;
+
+    RenderVisitor(RenderInfoPtr& render_info, const ViewUniformBufferPtr& view_uniform_buffer);
     ~RenderVisitor() override;
 
     RenderVisitor& operator = (RenderVisitor&&) noexcept = delete;
@@ -17,9 +38,38 @@ namespace Dental {
 
     virtual Type type() override { return Type::RENDER_VISITOR; }
 
+    // 是否跳过包围体在视锥外的节点和geometry
+    inline void culling(bool culling) { culling_ = culling; }
+    inline bool culling() const { return culling_; }
+
+    // 是否在CPU上做遮挡剔除, 跳过被大的geometry完全挡住的geometry
+    inline void occlusionCulling(bool occlusion_culling) { occlusion_culling_ = occlusion_culling; }
+    inline bool occlusionCulling() const { return occlusion_culling_; }
+
+    // 相机视口的缩放比例, 降低分辨率绘制到离屏目标时使用
+    inline void resolutionScale(float scale) { resolution_scale_ = scale; }
+    inline float resolutionScale() const { return resolution_scale_; }
+
+    // 设置后在原模型上额外叠加绘制提取的边, 使用简化层级时不绘制
+    inline void edgeTechnique(const RenderTechniquePtr& technique) { edge_technique_ = technique; }
+    inline const RenderTechniquePtr& edgeTechnique() const { return edge_technique_; }
+
+    virtual void apply(Node& node) override;
+
+    virtual void apply(Camera& camera) override;
+
     virtual void apply(Geometry& geometry) override;
 
   protected:
+    // 遮挡剔除后提交队列
+    void flush();
+
+    // 按包围球在屏幕上的面积选择简化层级
+    Geometry& selectLod(Geometry& geometry, const glm::mat4& mv);
+
+    // 返回是否还有可见的簇
+    bool cullClusters(Geometry& geometry, const glm::mat4& mv);
+
     void pushProjection(const glm::mat4& projection) override;
     void popProjection() override;
 
@@ -27,6 +77,27 @@ namespace Dental {
     void popViewport() override;
 
     RenderInfoPtr render_info_;
+
+    ViewUniformBufferPtr view_uniform_buffer_;
+    std::stack<glm::mat4> views_;
+
+    // 每个相机结束时提交, target为相机的序号
+    RenderQueue queue_;
+    unsigned int target_;
+
+    bool culling_;
+
+    float resolution_scale_;
+
+    bool occlusion_culling_;
+    OcclusionCuller occlusion_culler_;
+
+    RenderTechniquePtr edge_technique_;
+
+  public:
+    // 所有RenderVisitor累计的裁剪统计
+    static const CullStatistics& statistics();
+    static void resetStatistics();
   };
 
   using RenderVisitorPtr = std::shared_ptr<RenderVisitor>;
@@ -1,7 +1,11 @@
 #ifndef __UI_MENUBARUI_H__
 #define __UI_MENUBARUI_H__
 
+#include <string>
+#include <unordered_map>
 #include <ui/view.h>
+#include <reader_writer.h>
+#include <instanced_geometry.h>
 
 namespace Dental::UI {
   class MenuBar : public View {
@@ -14,6 +18,26 @@ namespace Dental::UI {
     MenuBar(MenuBar&&) noexcept = delete;
 
     void render() override;
+
+  private:
+    ReaderWriter::ReadOptions readOptions() const;
+
+    // 同一文件的部件只读取一次, 再次放置时增加实例
+    void placeComponent(const std::string& path);
+
+    bool optimize_vertex_cache_;
+    bool optimize_vertex_fetch_;
+    bool build_clusters_;
+    bool generate_lods_;
+    // 默认不烘焙环境光遮蔽, 不释放内存中的数据
+    bool bake_ambient_occlusion_;
+    bool release_after_upload_;
+    // 合并导入的小模型, 它们共用batch_technique_
+    bool batch_small_geometries_;
+    RenderTechniquePtr batch_technique_;
+
+    // 文件路径到放置的部件
+    std::unordered_map<std::string, InstancedGeometryPtr> components_;
   };
 
   using MenuBarPtr = std::shared_ptr<MenuBar>;
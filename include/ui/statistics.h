@@ -0,0 +1,23 @@
+#ifndef __UI_STATISTICS_H__
+#define __UI_STATISTICS_H__
+
+#include <ui/view.h>
+
+namespace Dental::UI {
+  class Statistics : public View {
+  public:
+    Statistics(Engine& engine, const std::string& name = "Statistics", bool visible = false);
+
+    ~Statistics() override;
+
+    Statistics& operator = (Statistics&&) noexcept = delete;
+    Statistics& operator = (const Statistics&) = delete;
+    Statistics(const Statistics&) = delete;
+    Statistics(Statistics&&) noexcept = delete;
+
+    void render() override;
+  };
+
+  using StatisticsPtr = std::shared_ptr<Statistics>;
+}
+#endif
@@ -6,6 +6,7 @@
 #include <ui/view.h>
 #include <viewer.h>
 #include <geometry.h>
+#include <gl_frame_buffer.h>
 
 namespace Dental::UI {
   class UnderCut : public View {
@@ -24,9 +25,23 @@ namespace Dental::UI {
     void geometry(const GeometryPtr&);
 
   private:
+    // 输入变化时重新绘制三个侧视图到各自的纹理
+    bool dirty(int width, int height) const;
+    void renderViews(int width, int height);
+
     std::array<Viewer, 3> viewers_;
+    std::array<GLFrameTextureBufferPtr, 3> targets_;
 
     GeometryPtr geometry_;
+
+    // 上次绘制侧视图时的输入
+    const Geometry* rendered_geometry_;
+    unsigned int rendered_revision_;
+    glm::mat4 rendered_model_;
+    glm::mat4 rendered_insertion_;
+    int rendered_width_;
+    int rendered_height_;
+    bool rendered_uploaded_;
   };
 
   using UnderCutPtr = std::shared_ptr<UnderCut>;
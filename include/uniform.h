@@ -22,6 +22,10 @@ namespace Dental {
 
     virtual void bind(int location) const = 0;
 
+    // 值的原始字节, 用于Program比较是否需要重新上传
+    virtual const void* data() const = 0;
+    virtual unsigned int size() const = 0;
+
     inline const std::string& name() const { return name_; }
 
     template <typename T>
@@ -86,6 +90,9 @@ namespace Dental {
 
     void bind(int location) const override;
 
+    const void* data() const override { return &value_; }
+    unsigned int size() const override { return sizeof(T); }
+
   protected:
     T value_;
   };
@@ -0,0 +1,52 @@
+#ifndef __UPLOAD_SCHEDULER_H__
+#define __UPLOAD_SCHEDULER_H__
+
+#include <glad/glad.h>
+
+namespace Dental {
+  // 限制每帧上传到缓冲的字节数, 大模型的数据分到多帧上传
+  class UploadScheduler {
+  public:
+    // 默认每帧8MB
+    static const GLsizeiptr DEFAULT_BUDGET = 8 * 1024 * 1024;
+
+    struct Statistics {
+      GLsizeiptr uploaded;
+      unsigned int throttled;
+    };
+
+    ~UploadScheduler() {}
+
+    UploadScheduler& operator = (UploadScheduler&&) noexcept = delete;
+    UploadScheduler& operator = (const UploadScheduler&) = delete;
+    UploadScheduler(const UploadScheduler&) = delete;
+    UploadScheduler(UploadScheduler&&) noexcept = delete;
+
+    static UploadScheduler& instance();
+
+    // 0为不限制
+    inline void budget(GLsizeiptr budget) { budget_ = budget; }
+    inline GLsizeiptr budget() const { return budget_; }
+
+    // 每帧开始时调用, 恢复预算并清零统计
+    void frame();
+
+    // 申请上传bytes字节, 返回本帧可以上传的字节数, 为granularity的整数倍
+    GLsizeiptr acquire(GLsizeiptr bytes, GLsizeiptr granularity = 1);
+
+    // 上一帧是否有缓冲因预算不足没有上传完, 需要继续绘制下一帧
+    inline bool pending() const { return pending_; }
+
+    inline const Statistics& statistics() const { return statistics_; }
+
+  private:
+    UploadScheduler();
+
+    GLsizeiptr budget_;
+    GLsizeiptr remaining_;
+    bool pending_;
+
+    Statistics statistics_;
+  };
+}
+#endif
@@ -0,0 +1,51 @@
+#ifndef __VIEW_UNIFORM_BUFFER_H__
+#define __VIEW_UNIFORM_BUFFER_H__
+
+#include <string>
+#include <memory>
+#include <glm/ext.hpp>
+#include <viewport.h>
+#include <gl_buffer_object.h>
+
+namespace Dental {
+  // 每个视图共享的std140 uniform block, 所有program通过同一binding point读取
+  class ViewUniformBuffer {
+  public:
+    static const unsigned int BINDING = 0;
+
+    static const char* blockName();
+
+    // 在#version之后插入View block的声明
+    static std::string inject(const std::string& source);
+
+    ViewUniformBuffer();
+    ~ViewUniformBuffer();
+
+    ViewUniformBuffer& operator = (ViewUniformBuffer&&) noexcept = delete;
+    ViewUniformBuffer& operator = (const ViewUniformBuffer&) = delete;
+    ViewUniformBuffer(const ViewUniformBuffer&) = delete;
+    ViewUniformBuffer(ViewUniformBuffer&&) noexcept = delete;
+
+    // 视图坐标系下的光源位置
+    void light(const glm::vec4& position);
+    inline const glm::vec4& light() const { return block_.light; }
+
+    // 内容未改变时不会重新上传
+    void update(const glm::mat4& projection, const glm::mat4& view, const Viewport& viewport);
+
+    void bind();
+
+  private:
+    struct Block {
+      glm::mat4 projection;
+      glm::mat4 view;
+      glm::vec4 viewport;
+      glm::vec4 light;
+    } block_;
+
+    GLBufferObjectPtr buffer_;
+  };
+
+  using ViewUniformBufferPtr = std::shared_ptr<ViewUniformBuffer>;
+}
+#endif
@@ -5,8 +5,14 @@
 #include <scene.h>
 #include <manipulator.h>
 #include <events.h>
+#include <view_uniform_buffer.h>
+#include <quality_governor.h>
+#include <gl_frame_buffer.h>
+#include <render_technique.h>
 
 namespace Dental {
+  class RenderVisitor;
+
   class Viewer : public std::enable_shared_from_this<Viewer> {
   public:
     Viewer();
@@ -29,19 +35,52 @@ namespace Dental {
 
     Event& moveEvent() { return move_event_; }
 
+    QualityGovernor& governor() { return governor_; }
+
+    // 叠加绘制的边, 第i位对应Geometry::Overlay的第i种, 为0时不绘制
+    void edgeOverlays(unsigned int mask) { edge_overlays_ = mask; }
+    unsigned int edgeOverlays() const { return edge_overlays_; }
+
+    // 烘焙完成的geometry用顶点遮蔽代替阴影绘制
+    void ambientOcclusion(bool ambient_occlusion) { ambient_occlusion_ = ambient_occlusion; }
+    bool ambientOcclusion() const { return ambient_occlusion_; }
+
+    // 相机在交互中, 或交互结束后还没有绘制完整质量的一帧
+    bool needRedraw();
+
   protected:
 
     void render(RenderInfoPtr& render_info);
 
+    // 以降低的分辨率绘制到离屏目标, 再放大到相机视口
+    void renderReduced(RenderInfoPtr& render_info);
+
+    // 按设置配置visitor, 如叠加的边
+    void setupVisitor(RenderVisitor& visitor);
+
     bool handleEvent(Event &event);
 
     ScenePtr scene_;
     
     ManipulatorPtr manipulator_;
 
+    ViewUniformBufferPtr view_uniform_buffer_;
+
     Events events_;
 
     Event move_event_;
+
+    QualityGovernor governor_;
+
+    // 降低分辨率时的离屏目标, 单采样才能缩放拷贝
+    GLFrameRenderBufferPtr reduced_buffer_;
+
+    unsigned int edge_overlays_;
+
+    bool ambient_occlusion_;
+
+    // 第一次显示边时创建, 构造Viewer时还没有GL上下文
+    EdgeRenderTechniquePtr edge_technique_;
   };
 
   using ViewerPtr = std::shared_ptr<Viewer>;
@@ -0,0 +1,416 @@
+#include <algorithm>
+#include <cmath>
+#include <ambient_occlusion_baker.h>
+
+namespace {
+  // 叶子节点最多的三角形数
+  const unsigned int LEAF_TRIANGLES = 4;
+
+  // 每个线程一次领取的顶点数
+  const unsigned int CHUNK_VERTICES = 1024;
+
+  // 射线起点沿法向的偏移, 相对包围球半径, 避免与自身所在的三角形相交
+  const float ORIGIN_OFFSET_RATIO = 1e-4f;
+
+  struct BvhNode {
+    glm::vec3 min;
+    glm::vec3 max;
+    // 叶子节点的三角形范围, count为0时是内部节点, 左子节点紧随其后, right为右子节点
+    unsigned int first;
+    unsigned int count;
+    unsigned int right;
+  };
+
+  // 三角形的包围盒层次, 按质心在最长轴的中位数划分
+  class Bvh {
+  public:
+    Bvh(const std::vector<glm::vec3>& vertices, const std::vector<unsigned int>& indices) :
+      vertices_(vertices) {
+      auto count = (unsigned int)(indices.size() / 3);
+      triangles_.reserve(count);
+      centroids_.reserve(count);
+      for (unsigned int i = 0; i < count; ++i) {
+        glm::uvec3 triangle(indices[i * 3], indices[i * 3 + 1], indices[i * 3 + 2]);
+        if (triangle.x >= vertices.size() || triangle.y >= vertices.size() || triangle.z >= vertices.size()) {
+          continue;
+        }
+        triangles_.emplace_back(triangle);
+        centroids_.emplace_back((vertices[triangle.x] + vertices[triangle.y] + vertices[triangle.z]) / 3.f);
+      }
+
+      if (!triangles_.empty()) {
+        nodes_.reserve(triangles_.size() * 2 / LEAF_TRIANGLES + 1);
+        build(0, (unsigned int)triangles_.size());
+      }
+    }
+
+    // 射线在max_t之内是否与任意三角形相交
+    bool occluded(const glm::vec3& origin, const glm::vec3& direction, float max_t) const {
+      if (nodes_.empty()) {
+        return false;
+      }
+
+      glm::vec3 inverse(1.f / direction.x, 1.f / direction.y, 1.f / direction.z);
+
+      unsigned int stack[64];
+      unsigned int size = 0;
+      stack[size++] = 0;
+      while (size) {
+        auto& node = nodes_[stack[--size]];
+        if (!intersectBox(node, origin, inverse, max_t)) {
+          continue;
+        }
+
+        if (node.count) {
+          for (unsigned int i = node.first; i < node.first + node.count; ++i) {
+            if (intersectTriangle(triangles_[i], origin, direction, max_t)) {
+              return true;
+            }
+          }
+        } else if (size + 2 <= 64) {
+          stack[size++] = node.right;
+          stack[size++] = (unsigned int)(&node - nodes_.data()) + 1;
+        }
+      }
+      return false;
+    }
+
+  private:
+    unsigned int build(unsigned int first, unsigned int count) {
+      auto index = (unsigned int)nodes_.size();
+      nodes_.emplace_back();
+
+      glm::vec3 min(std::numeric_limits<float>::max());
+      glm::vec3 max(-std::numeric_limits<float>::max());
+      glm::vec3 centroid_min = min;
+      glm::vec3 centroid_max = max;
+      for (unsigned int i = first; i < first + count; ++i) {
+        for (int j = 0; j < 3; ++j) {
+          auto& vertex = vertices_[triangles_[i][j]];
+          min = glm::min(min, vertex);
+          max = glm::max(max, vertex);
+        }
+        centroid_min = glm::min(centroid_min, centroids_[i]);
+        centroid_max = glm::max(centroid_max, centroids_[i]);
+      }
+
+      nodes_[index].min = min;
+      nodes_[index].max = max;
+
+      auto extent = centroid_max - centroid_min;
+      if (count <= LEAF_TRIANGLES || (extent.x <= 0.f && extent.y <= 0.f && extent.z <= 0.f)) {
+        nodes_[index].first = first;
+        nodes_[index].count = count;
+        nodes_[index].right = 0;
+        return index;
+      }
+
+      int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+      // 三角形和质心一起排序
+      std::vector<unsigned int> order(count);
+      for (unsigned int i = 0; i < count; ++i) {
+        order[i] = first + i;
+      }
+      auto middle = order.begin() + count / 2;
+      std::nth_element(order.begin(), middle, order.end(), [this, axis](unsigned int a, unsigned int b) {
+        return centroids_[a][axis] < centroids_[b][axis];
+      });
+
+      std::vector<glm::uvec3> triangles(count);
+      std::vector<glm::vec3> centroids(count);
+      for (unsigned int i = 0; i < count; ++i) {
+        triangles[i] = triangles_[order[i]];
+        centroids[i] = centroids_[order[i]];
+      }
+      std::copy(triangles.begin(), triangles.end(), triangles_.begin() + first);
+      std::copy(centroids.begin(), centroids.end(), centroids_.begin() + first);
+
+      nodes_[index].first = 0;
+      nodes_[index].count = 0;
+      build(first, count / 2);
+      auto right = build(first + count / 2, count - count / 2);
+      nodes_[index].right = right;
+      return index;
+    }
+
+    static bool intersectBox(const BvhNode& node, const glm::vec3& origin, const glm::vec3& inverse, float max_t) {
+      auto t0 = (node.min - origin) * inverse;
+      auto t1 = (node.max - origin) * inverse;
+      auto near = glm::min(t0, t1);
+      auto far = glm::max(t0, t1);
+      auto enter = std::max(std::max(near.x, near.y), std::max(near.z, 0.f));
+      auto exit = std::min(std::min(far.x, far.y), std::min(far.z, max_t));
+      return enter <= exit;
+    }
+
+    // Moller-Trumbore, 正反面都算相交
+    bool intersectTriangle(const glm::uvec3& triangle, const glm::vec3& origin, const glm::vec3& direction, float max_t) const {
+      auto& a = vertices_[triangle.x];
+      auto edge1 = vertices_[triangle.y] - a;
+      auto edge2 = vertices_[triangle.z] - a;
+      auto p = glm::cross(direction, edge2);
+      auto determinant = glm::dot(edge1, p);
+      if (std::abs(determinant) < 1e-12f) {
+        return false;
+      }
+
+      auto inverse = 1.f / determinant;
+      auto s = origin - a;
+      auto u = glm::dot(s, p) * inverse;
+      if (u < 0.f || u > 1.f) {
+        return false;
+      }
+
+      auto q = glm::cross(s, edge1);
+      auto v = glm::dot(direction, q) * inverse;
+      if (v < 0.f || u + v > 1.f) {
+        return false;
+      }
+
+      auto t = glm::dot(edge2, q) * inverse;
+      return t > 0.f && t < max_t;
+    }
+
+    const std::vector<glm::vec3>& vertices_;
+    std::vector<glm::uvec3> triangles_;
+    std::vector<glm::vec3> centroids_;
+    std::vector<BvhNode> nodes_;
+  };
+
+  float radicalInverse(unsigned int bits) {
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return bits * 2.3283064365386963e-10f;
+  }
+
+  // 顶点序号的哈希, 用于旋转每个顶点的采样方向, 相邻顶点的噪声不相关
+  float hashAngle(unsigned int index) {
+    index ^= index >> 16;
+    index *= 0x7feb352du;
+    index ^= index >> 15;
+    index *= 0x846ca68bu;
+    index ^= index >> 16;
+    return index * 2.3283064365386963e-10f * 6.2831853f;
+  }
+}
+
+namespace Dental {
+  AmbientOcclusionBaker::AmbientOcclusionBaker() :
+    stop_(false),
+    thread_(&AmbientOcclusionBaker::run, this) {
+  }
+
+  AmbientOcclusionBaker::~AmbientOcclusionBaker() {
+    stop_ = true;
+    condition_.notify_all();
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+  AmbientOcclusionBaker& AmbientOcclusionBaker::instance() {
+    static AmbientOcclusionBaker baker;
+    return baker;
+  }
+
+  bool AmbientOcclusionBaker::request(const GeometryPtr& geometry) {
+    if (!geometry || !geometry->restore()) {
+      return false;
+    }
+
+    auto elements = std::dynamic_pointer_cast<DrawElementsUInt>(geometry->primitiveSet(0));
+    if (!elements || elements->mode() != PrimitiveSet::Mode::TRIANGLES || elements->size() < 3) {
+      return false;
+    }
+
+    Job job;
+    job.geometry = geometry;
+    job.revision = geometry->revision();
+    job.vertices.assign(geometry->vertexArray()->begin(), geometry->vertexArray()->end());
+    if (geometry->normalArray()->size() == geometry->vertexArray()->size()) {
+      job.normals.assign(geometry->normalArray()->begin(), geometry->normalArray()->end());
+    }
+    job.indices.assign(elements->begin(), elements->begin() + elements->size() / 3 * 3);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_.emplace_back(std::move(job));
+    }
+    condition_.notify_one();
+    return true;
+  }
+
+  bool AmbientOcclusionBaker::ready() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !finished_.empty();
+  }
+
+  unsigned int AmbientOcclusionBaker::frame() {
+    std::vector<Job> finished;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      finished.swap(finished_);
+    }
+
+    unsigned int count = 0;
+    for (auto& job : finished) {
+      auto geometry = job.geometry.lock();
+      if (!geometry || geometry->revision() != job.revision ||
+          job.occlusion.size() != geometry->vertexArray()->numElements()) {
+        continue;
+      }
+
+      auto occlusion = std::make_shared<FloatArray>();
+      occlusion->assign(job.occlusion.begin(), job.occlusion.end());
+      geometry->occlusionArray(occlusion);
+
+      // 已生成的简化层级各自烘焙
+      for (auto& lod : geometry->lods()) {
+        if (!lod->occlusionArray()) {
+          request(lod);
+        }
+      }
+      ++count;
+    }
+
+    return count;
+  }
+
+  void AmbientOcclusionBaker::run() {
+    while (true) {
+      Job job;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [this]() { return stop_ || !pending_.empty(); });
+        if (stop_) {
+          return;
+        }
+
+        job = std::move(pending_.front());
+        pending_.pop_front();
+      }
+
+      // geometry已经析构时不再烘焙
+      if (job.geometry.expired()) {
+        continue;
+      }
+
+      job.occlusion = bake(job.vertices, job.normals, job.indices, &stop_);
+      if (stop_) {
+        return;
+      }
+
+      job.vertices = {};
+      job.normals = {};
+      job.indices = {};
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      finished_.emplace_back(std::move(job));
+    }
+  }
+
+  std::vector<float> AmbientOcclusionBaker::bake(const std::vector<glm::vec3>& vertices,
+                                                 const std::vector<glm::vec3>& normals,
+                                                 const std::vector<unsigned int>& indices,
+                                                 const std::atomic<bool>* stop) {
+    std::vector<float> occlusion(vertices.size(), 1.f);
+    if (vertices.empty() || indices.size() < 3) {
+      return occlusion;
+    }
+
+    // 没有法向时按面积加权的面法向计算
+    std::vector<glm::vec3> computed;
+    if (normals.size() != vertices.size()) {
+      computed.assign(vertices.size(), glm::vec3(0.f));
+      for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+        if (indices[i] >= vertices.size() || indices[i + 1] >= vertices.size() || indices[i + 2] >= vertices.size()) {
+          continue;
+        }
+        auto& a = vertices[indices[i]];
+        auto normal = glm::cross(vertices[indices[i + 1]] - a, vertices[indices[i + 2]] - a);
+        computed[indices[i]] += normal;
+        computed[indices[i + 1]] += normal;
+        computed[indices[i + 2]] += normal;
+      }
+    }
+    auto& vertex_normals = computed.empty() ? normals : computed;
+
+    glm::vec3 min(std::numeric_limits<float>::max());
+    glm::vec3 max(-std::numeric_limits<float>::max());
+    for (auto& vertex : vertices) {
+      min = glm::min(min, vertex);
+      max = glm::max(max, vertex);
+    }
+    auto radius = glm::length(max - min) * 0.5f;
+    auto distance = radius * DISTANCE_RATIO;
+    auto offset = radius * ORIGIN_OFFSET_RATIO;
+
+    Bvh bvh(vertices, indices);
+
+    // Hammersley点集映射为余弦分布的半球方向, z轴为法向
+    std::vector<glm::vec3> directions(RAYS);
+    for (unsigned int i = 0; i < RAYS; ++i) {
+      float u = (i + 0.5f) / RAYS;
+      float v = radicalInverse(i);
+      float r = std::sqrt(u);
+      float phi = v * 6.2831853f;
+      directions[i] = glm::vec3(r * std::cos(phi), r * std::sin(phi), std::sqrt(std::max(0.f, 1.f - u)));
+    }
+
+    std::atomic<unsigned int> next(0);
+    auto worker = [&]() {
+      while (!(stop && *stop)) {
+        auto first = next.fetch_add(CHUNK_VERTICES);
+        if (first >= vertices.size()) {
+          return;
+        }
+
+        auto last = std::min<std::size_t>(first + CHUNK_VERTICES, vertices.size());
+        for (auto i = first; i < last; ++i) {
+          auto normal = vertex_normals[i];
+          if (glm::length2(normal) <= 0.f) {
+            continue;
+          }
+          normal = glm::normalize(normal);
+
+          // 以法向为z轴的正交基, 绕法向随机旋转
+          auto helper = std::abs(normal.x) > 0.9f ? glm::vec3(0.f, 1.f, 0.f) : glm::vec3(1.f, 0.f, 0.f);
+          auto tangent = glm::normalize(glm::cross(helper, normal));
+          auto bitangent = glm::cross(normal, tangent);
+          auto angle = hashAngle(i);
+          auto c = std::cos(angle);
+          auto s = std::sin(angle);
+          auto x = tangent * c + bitangent * s;
+          auto y = bitangent * c - tangent * s;
+
+          auto origin = vertices[i] + normal * offset;
+          unsigned int hits = 0;
+          for (auto& direction : directions) {
+            auto ray = x * direction.x + y * direction.y + normal * direction.z;
+            if (bvh.occluded(origin, ray, distance)) {
+              ++hits;
+            }
+          }
+          occlusion[i] = 1.f - hits / (float)RAYS;
+        }
+      }
+    };
+
+    // 后台线程本身也参与计算
+    auto count = std::max(1u, std::thread::hardware_concurrency()) - 1;
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < count; ++i) {
+      threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    return occlusion;
+  }
+}
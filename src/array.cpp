@@ -6,23 +6,19 @@ namespace Dental {
   GLArrayObject::GLArrayObject(
     short data_type_size, short gl_data_size,
     unsigned long gl_data_type) :
-    data_size_(0),
-    data_(nullptr),
-    vbo_(0),
+    GLBufferObject(GL_ARRAY_BUFFER, data_type_size),
     index_(-1),
-    dirty_(false) {
+    divisor_(0) {
     profile_.gl_data_size = gl_data_size;
     profile_.gl_data_type = gl_data_type;
-    profile_.data_type_size = data_type_size;
   }
 
   void GLArrayObject::bindIndex(unsigned int index) {
     index_ = index;
   }
 
-  void GLArrayObject::bindData(GLsizeiptr data_size, void* data) {
-    data_size_ = data_size;
-    data_ = data;
+  void GLArrayObject::divisor(unsigned int divisor) {
+    divisor_ = divisor;
   }
 
   void GLArrayObject::bind() {
@@ -31,32 +27,24 @@ namespace Dental {
       return;
     }
 #ifdef ENABLE_BUFFER
-    if (!vbo_) {
-      glGenBuffers(1, &vbo_);
-      dirty_ = true;
-    }
+    upload();
 
-    if (!vbo_) {
+    if (!buffer_) {
       return;
     }
 
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-
-    if (dirty_) {
-      glBufferData(GL_ARRAY_BUFFER, data_size_ * profile_.data_type_size, data_,
-                   GL_STATIC_DRAW);
-      dirty_ = false;
-    }
-
     if (index_ != -1) {
-      glVertexAttribPointer(index_, profile_.gl_data_size, profile_.gl_data_type, GL_FALSE,
-                            profile_.data_type_size, 0);
-      glEnableVertexAttribArray(index_);
+      for (int column = 0; column < columns(); ++column) {
+        glVertexAttribPointer(index_ + column, profile_.gl_data_size, profile_.gl_data_type, GL_FALSE,
+                              data_type_size_, (const void*)((std::size_t)column * data_type_size_ / columns()));
+        glEnableVertexAttribArray(index_ + column);
+        glVertexAttribDivisor(index_ + column, divisor_);
+      }
     }
 #else
     if (index_ != -1) {
       glVertexAttribPointer(index_, profile_.gl_data_size, profile_.gl_data_type, GL_FALSE,
-                            profile_.data_type_size, data_);
+                            data_type_size_, data_);
       glEnableVertexAttribArray(index_);
     }
 #endif
@@ -64,23 +52,20 @@ namespace Dental {
 
   void GLArrayObject::unbind() {
     if (index_ != -1) {
-      glDisableVertexAttribArray(index_);
-    }
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-  }
-
-  void GLArrayObject::release() {
-    if (vbo_) {
-      glDeleteBuffers(1, &vbo_);
-      vbo_ = 0;
+      for (int column = 0; column < columns(); ++column) {
+        glDisableVertexAttribArray(index_ + column);
+      }
     }
+    GLBufferObject::unbind();
   }
 
-  void GLArrayObject::dirty() {
-    dirty_ = true;
+  int GLArrayObject::columns() const {
+    // 元素大于一个属性时(如mat4)按列拆分
+    int attrib_size = profile_.gl_data_size * sizeof(GLfloat);
+    return profile_.gl_data_type == GL_FLOAT && data_type_size_ > attrib_size ? data_type_size_ / attrib_size : 1;
   }
 
   bool GLArrayObject::valid() {
-    return !dirty_ && index_ != -1 && vbo_ != 0;
+    return GLBufferObject::valid() && index_ != -1;
   }
 }
\ No newline at end of file
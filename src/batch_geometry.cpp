@@ -0,0 +1,331 @@
+#include <algorithm>
+#include <tuple>
+#include <glad/glad.h>
+#include <batch_geometry.h>
+#include <node.h>
+#include <gl_state.h>
+#include <gl_delete_queue.h>
+
+namespace Dental {
+  BatchGeometry::BatchGeometry() : Geometry(),
+    object_array_(std::make_shared<FloatArray>()),
+    elements_(std::make_shared<DrawElementsUInt>(PrimitiveSet::Mode::TRIANGLES)),
+    transform_texture_(0),
+    transform_rows_(0),
+    dirty_first_(0),
+    dirty_last_(0) {
+    attribArray(static_cast<std::underlying_type<Attrib>::type>(Attrib::OBJECT), object_array_);
+    addPrimitiveSet(elements_);
+  }
+
+  BatchGeometry::~BatchGeometry() {
+    GLDeleteQueue::instance().push(GLDeleteQueue::Type::TEXTURE, transform_texture_);
+  }
+
+  namespace {
+    // 同组的geometry用同一个technique实例和纹理绘制, 顶点属性一致
+    using BatchKey = std::tuple<RenderTechnique*, Texture*, bool, bool>;
+
+    BatchKey batchKey(const Geometry& geometry) {
+      // 数据释放后数组为空, 按GL缓冲中的元素个数判断
+      return BatchKey(
+        geometry.renderTechnique().get(),
+        geometry.texture().get(),
+        geometry.colorArray()->numElements() != 0,
+        geometry.texcoordArray()->numElements() != 0);
+    }
+
+    unsigned int numTriangles(const Geometry& geometry) {
+      unsigned int triangles = 0;
+      for (unsigned int i = 0; i < geometry.numPrimitiveSets(); ++i) {
+        triangles += geometry.primitiveSet(i)->numIndices() / 3;
+      }
+      return triangles;
+    }
+  }
+
+  std::vector<BatchGeometryPtr> BatchGeometry::create(const std::vector<GeometryPtr>& geometries) {
+    std::vector<std::pair<BatchKey, BatchGeometryPtr>> batches;
+    for (auto& geometry : geometries) {
+      if (!batchable(*geometry)) {
+        continue;
+      }
+
+      auto key = batchKey(*geometry);
+      auto itr = std::find_if(batches.begin(), batches.end(), [&](const auto& batch) {
+        return batch.first == key;
+      });
+
+      if (itr == batches.end()) {
+        auto batch = std::make_shared<BatchGeometry>();
+        batch->renderTechnique(geometry->renderTechnique());
+        if (geometry->texture()) {
+          batch->texture(geometry->texture());
+        }
+        batches.emplace_back(key, batch);
+        itr = std::prev(batches.end());
+      }
+      itr->second->add(*geometry);
+    }
+
+    std::vector<BatchGeometryPtr> result;
+    for (auto& batch : batches) {
+      result.emplace_back(batch.second);
+    }
+    return result;
+  }
+
+  bool BatchGeometry::batchable(const Geometry& geometry) {
+    auto& technique = geometry.renderTechnique();
+    if (geometry.className() != "Geometry" || !technique || !technique->supports(ProgramVariant::BATCH)) {
+      return false;
+    }
+
+    if (!geometry.attribArrays().empty() || geometry.textures().size() > (geometry.texture() ? 1u : 0u)) {
+      return false;
+    }
+
+    for (unsigned int i = 0; i < geometry.numPrimitiveSets(); ++i) {
+      if (geometry.primitiveSet(i)->mode() != PrimitiveSet::Mode::TRIANGLES) {
+        return false;
+      }
+    }
+    return geometry.numPrimitiveSets() != 0;
+  }
+
+  unsigned int BatchGeometry::merge(Node& node, unsigned int max_triangles) {
+    std::vector<std::pair<BatchKey, BatchGeometryPtr>> batches;
+    std::vector<std::pair<BatchKey, std::vector<GeometryPtr>>> groups;
+    for (unsigned int i = 0; i < node.numGeometry(); ++i) {
+      auto geometry = node.geometry(i);
+      if (auto batch = std::dynamic_pointer_cast<BatchGeometry>(geometry)) {
+        batches.emplace_back(batchKey(*batch), batch);
+        continue;
+      }
+
+      if (!batchable(*geometry) || numTriangles(*geometry) >= max_triangles) {
+        continue;
+      }
+
+      auto key = batchKey(*geometry);
+      auto itr = std::find_if(groups.begin(), groups.end(), [&](const auto& group) {
+        return group.first == key;
+      });
+      if (itr == groups.end()) {
+        groups.emplace_back(key, std::vector<GeometryPtr>());
+        itr = std::prev(groups.end());
+      }
+      itr->second.emplace_back(geometry);
+    }
+
+    unsigned int merged = 0;
+    for (auto& group : groups) {
+      auto itr = std::find_if(batches.begin(), batches.end(), [&](const auto& batch) {
+        return batch.first == group.first;
+      });
+
+      auto& geometries = group.second;
+      if (itr != batches.end()) {
+        for (auto& geometry : geometries) {
+          itr->second->add(*geometry);
+          node.removeGeometry(geometry);
+        }
+      } else if (geometries.size() > 1) {
+        auto index = node.geometryIndex(geometries.front());
+        for (auto& geometry : geometries) {
+          node.removeGeometry(geometry);
+        }
+        node.insertGeometry((unsigned int)index, create(geometries).front());
+      } else {
+        continue;
+      }
+      merged += (unsigned int)geometries.size();
+    }
+    return merged;
+  }
+
+  unsigned int BatchGeometry::add(const Geometry& geometry) {
+    geometry.restore();
+
+    auto& vertices = *geometry.vertexArray();
+    auto& normals = *geometry.normalArray();
+    auto& colors = *geometry.colorArray();
+    auto& texcoords = *geometry.texcoordArray();
+    auto base = (unsigned int)vertex_array_->size();
+
+    // 有一个对象带颜色或纹理坐标时, 其余对象补白色和原点
+    bool has_colors = !colors.empty() || !color_array_->empty();
+    bool has_texcoords = !texcoords.empty() || !texcoord_array_->empty();
+    if (has_colors) {
+      color_array_->resize(base, glm::vec4(1.f));
+    }
+    if (has_texcoords) {
+      texcoord_array_->resize(base, glm::vec2(0.f));
+    }
+    auto index = (unsigned int)objects_.size();
+
+    Object object;
+    object.name = geometry.name();
+    object.first = (unsigned int)elements_->size();
+    object.transform = geometry.mv();
+    object.visible = true;
+
+    for (std::size_t i = 0; i < vertices.size(); ++i) {
+      vertex_array_->emplace_back(vertices[i]);
+      normal_array_->emplace_back(i < normals.size() ? normals[i] : glm::vec3(0.f, 0.f, 1.f));
+      if (has_colors) {
+        color_array_->emplace_back(i < colors.size() ? colors[i] : glm::vec4(1.f));
+      }
+      if (has_texcoords) {
+        texcoord_array_->emplace_back(i < texcoords.size() ? texcoords[i] : glm::vec2(0.f));
+      }
+      object_array_->emplace_back((float)index);
+      object.box.expandBy(vertices[i]);
+    }
+
+    for (unsigned int i = 0; i < geometry.numPrimitiveSets(); ++i) {
+      auto primitive_set = geometry.primitiveSet(i);
+      if (primitive_set->mode() != PrimitiveSet::Mode::TRIANGLES) {
+        continue;
+      }
+
+      // 读回失败时索引不在内存中
+      auto count = geometry.resident() ? primitive_set->numIndices() / 3 * 3 : 0;
+      for (unsigned int j = 0; j < count; ++j) {
+        elements_->emplace_back(base + primitive_set->index(j));
+      }
+    }
+
+    object.count = (unsigned int)elements_->size() - object.first;
+    objects_.emplace_back(object);
+
+    dirtyTransform(index);
+    dirty();
+    dirtyBounding();
+    return index;
+  }
+
+  void BatchGeometry::transform(unsigned int index, const glm::mat4& transform) {
+    if (index >= objects_.size()) {
+      return;
+    }
+
+    objects_[index].transform = transform;
+    dirtyTransform(index);
+    dirtyBounding();
+  }
+
+  void BatchGeometry::visible(unsigned int index, bool visible) {
+    if (index >= objects_.size()) {
+      return;
+    }
+
+    objects_[index].visible = visible;
+    dirtyBounding();
+  }
+
+  void BatchGeometry::dirtyTransform(unsigned int index) {
+    if (dirty_first_ == dirty_last_) {
+      dirty_first_ = index;
+      dirty_last_ = index + 1;
+    } else {
+      dirty_first_ = std::min(dirty_first_, index);
+      dirty_last_ = std::max(dirty_last_, index + 1);
+    }
+  }
+
+  void BatchGeometry::uploadTransforms() {
+    if (!transform_texture_) {
+      glGenTextures(1, &transform_texture_);
+      transform_rows_ = 0;
+    }
+
+    GLState::instance().bindTexture(TRANSFORM_UNIT, transform_texture_);
+
+    // 每个对象占一行, 四个texel为矩阵的四列
+    auto rows = (unsigned int)objects_.size();
+    if (transform_rows_ != rows) {
+      std::vector<glm::mat4> transforms;
+      transforms.reserve(rows);
+      for (auto& object : objects_) {
+        transforms.emplace_back(object.transform);
+      }
+
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, 4, rows, 0, GL_RGBA, GL_FLOAT, transforms.data());
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+      transform_rows_ = rows;
+    } else {
+      for (auto i = dirty_first_; i < dirty_last_ && i < rows; ++i) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, i, 4, 1, GL_RGBA, GL_FLOAT, &objects_[i].transform);
+      }
+    }
+
+    dirty_first_ = dirty_last_ = 0;
+  }
+
+  void BatchGeometry::bindVariant(Program& program) {
+    if (objects_.empty()) {
+      return;
+    }
+
+    if (!transform_texture_ || dirty_first_ != dirty_last_ || transform_rows_ != objects_.size()) {
+      uploadTransforms();
+    } else {
+      GLState::instance().bindTexture(TRANSFORM_UNIT, transform_texture_);
+    }
+
+    program.uniform("uTransforms", (int)TRANSFORM_UNIT);
+  }
+
+  void BatchGeometry::drawPrimitives() {
+    if (!element_buffer_) {
+      return;
+    }
+
+    // 合并相邻的可见对象, 减少绘制次数
+    unsigned int first = 0;
+    unsigned int count = 0;
+    for (auto& object : objects_) {
+      if (!object.visible || !object.count) {
+        continue;
+      }
+
+      if (count && first + count == object.first) {
+        count += object.count;
+        continue;
+      }
+
+      if (count) {
+        element_buffer_->draw(first, count);
+      }
+      first = object.first;
+      count = object.count;
+    }
+
+    if (count) {
+      element_buffer_->draw(first, count);
+    }
+  }
+
+  void BatchGeometry::computeBounding() {
+    if (!dirty_bounding_ && bounding_sphere_.valid()) {
+      return;
+    }
+
+    dirty_bounding_ = false;
+    bounding_sphere_.init();
+
+    for (auto& object : objects_) {
+      if (!object.visible || !object.box.valid()) {
+        continue;
+      }
+
+      auto matrix = mv_ * object.transform;
+      for (unsigned int i = 0; i < 8; ++i) {
+        glm::vec4 corner = matrix * glm::vec4(object.box.corner(i), 1.f);
+        bounding_sphere_.expandBy(glm::vec3(corner / corner.w));
+      }
+    }
+  }
+}
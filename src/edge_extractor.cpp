@@ -0,0 +1,124 @@
+#include <edge_extractor.h>
+#include <timer.h>
+
+namespace Dental {
+  EdgeExtractor::EdgeExtractor() :
+    milliseconds_(0.f),
+    stop_(false),
+    thread_(&EdgeExtractor::run, this) {
+  }
+
+  EdgeExtractor::~EdgeExtractor() {
+    stop_ = true;
+    condition_.notify_all();
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+  EdgeExtractor& EdgeExtractor::instance() {
+    static EdgeExtractor extractor;
+    return extractor;
+  }
+
+  bool EdgeExtractor::request(const GeometryPtr& geometry) {
+    if (!geometry) {
+      return false;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto itr = requested_.find(geometry.get());
+      if (itr != requested_.end() && itr->second == geometry->revision()) {
+        return true;
+      }
+    }
+
+    if (!geometry->restore()) {
+      return false;
+    }
+
+    Job job;
+    job.geometry = geometry;
+    job.key = geometry.get();
+    job.revision = geometry->revision();
+    job.vertices.assign(geometry->vertexArray()->begin(), geometry->vertexArray()->end());
+    job.indices = MeshOptimizer::collectTriangles(*geometry);
+    job.milliseconds = 0.f;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      requested_[job.key] = job.revision;
+      pending_.emplace_back(std::move(job));
+    }
+    condition_.notify_one();
+    return true;
+  }
+
+  bool EdgeExtractor::ready() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !finished_.empty();
+  }
+
+  unsigned int EdgeExtractor::frame() {
+    std::vector<Job> finished;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      finished.swap(finished_);
+
+      // 之后又请求了新的revision时保留记录
+      for (auto& job : finished) {
+        auto itr = requested_.find(job.key);
+        if (itr != requested_.end() && itr->second == job.revision) {
+          requested_.erase(itr);
+        }
+      }
+    }
+
+    unsigned int count = 0;
+    for (auto& job : finished) {
+      auto geometry = job.geometry.lock();
+      if (!geometry || geometry->revision() != job.revision) {
+        continue;
+      }
+
+      MeshOptimizer::setOverlays(*geometry, job.edges);
+      milliseconds_ = job.milliseconds;
+      ++count;
+    }
+
+    return count;
+  }
+
+  void EdgeExtractor::run() {
+    while (true) {
+      Job job;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [this]() { return stop_ || !pending_.empty(); });
+        if (stop_) {
+          return;
+        }
+
+        job = std::move(pending_.front());
+        pending_.pop_front();
+      }
+
+      // geometry已经析构时不再提取, 交给frame()清除请求记录
+      if (!job.geometry.expired()) {
+        Timer timer;
+        job.edges = MeshOptimizer::extractEdges(job.indices, job.vertices);
+        job.milliseconds = (float)timer.time_m();
+      }
+      if (stop_) {
+        return;
+      }
+
+      job.vertices = {};
+      job.indices = {};
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      finished_.emplace_back(std::move(job));
+    }
+  }
+}
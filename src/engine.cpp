@@ -12,7 +12,17 @@
 #include <ui/undercut.h>
 #include <ui/project.h>
 #include <ui/preview.h>
+#include <ui/statistics.h>
 #include <render_visitor.h>
+#include <gl_state.h>
+#include <render_queue.h>
+#include <upload_scheduler.h>
+#include <gl_delete_queue.h>
+#include <lod_generator.h>
+#include <ambient_occlusion_baker.h>
+#include <edge_extractor.h>
+#include <render_target_pool.h>
+#include <timer.h>
 
 namespace Dental {
   Engine::Engine() :
@@ -21,6 +31,7 @@ namespace Dental {
     uiviews_.emplace_back(std::make_shared<UI::MenuBar>(*this));
     uiviews_.emplace_back(std::make_shared<UI::UnderCut>(*this));
     // uiviews_.emplace_back(std::make_shared<UI::Preview>(*this));
+    uiviews_.emplace_back(std::make_shared<UI::Statistics>(*this));
   }
 
   Engine::~Engine() {
@@ -33,19 +44,20 @@ namespace Dental {
         GLuint tex;
 
         glGenTextures(1, &tex);
-        glBindTexture(GL_TEXTURE_2D, tex);
+        GLState::instance().bindTexture(tex);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, (fmt == 0) ? GL_RGBA : GL_RGBA, GL_UNSIGNED_BYTE, data);
         glGenerateMipmap(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        GLState::instance().bindTexture(0);
 
         return (void*)(size_t)tex;
       };
       ifd::FileDialog::Instance().DeleteTexture = [](void* tex) {
         GLuint texID = (GLuint)((uintptr_t)tex);
+        GLState::instance().forgetTexture(texID);
         glDeleteTextures(1, &texID);
       };
       ifd::FileDialog::Instance().SetZoom(1.f);
@@ -117,6 +129,8 @@ namespace Dental {
       std::cout << "failed to load glad" << std::endl;
     }
 
+    GLState::instance().invalidate();
+
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
 
@@ -228,7 +242,10 @@ namespace Dental {
   }
 
   bool Engine::needRedraw() {
-    return ImGui::HasEvent() || ImGui::IsItemToggledOpen() || !viewer_->events().empty();
+    return ImGui::HasEvent() || ImGui::IsItemToggledOpen() || !viewer_->events().empty() ||
+      UploadScheduler::instance().pending() || LodGenerator::instance().ready() ||
+      AmbientOcclusionBaker::instance().ready() || EdgeExtractor::instance().ready() ||
+      viewer_->needRedraw();
   }
 
   void Engine::run() {
@@ -237,17 +254,35 @@ namespace Dental {
     while (!glfwWindowShouldClose(window_)) {
       glfwPollEvents();
 
+      // 其他线程释放的GL对象在这里统一删除
+      GLDeleteQueue::instance().flush();
+
       if (needRedraw()) {
+        auto frame_start = Timer::now();
+
+        RenderQueue::resetStatistics();
+        PrimitiveSet::resetStatistics();
+        RenderVisitor::resetStatistics();
+        GLState::instance().resetStatistics();
+        Program::resetStatistics();
+        ShadowRenderTechnique::resetStatistics();
+        UploadScheduler::instance().frame();
+        RenderTargetPool::instance().frame();
+        LodGenerator::instance().frame();
+        AmbientOcclusionBaker::instance().frame();
+        EdgeExtractor::instance().frame();
+
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
         glClearColor(0.45f, 0.55f, 0.60f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glEnable(GL_CULL_FACE);
-        glEnable(GL_DEPTH_TEST);
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        // ImGui_ImplOpenGL3_RenderDrawData会恢复它修改的状态, 记录跨帧有效
+        GLState::instance().enable(GL_CULL_FACE);
+        GLState::instance().enable(GL_DEPTH_TEST);
+        GLState::instance().enable(GL_BLEND);
+        GLState::instance().blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
         render();
 
@@ -255,9 +290,15 @@ namespace Dental {
           uiview->render();
         }
 
+        // ImGui只在纹理单元0上恢复纹理绑定
+        GLState::instance().activeTexture(0);
+
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
         glfwSwapBuffers(window_);
+
+        // 交换缓冲会等待GPU完成, 帧时间包含GPU的耗时
+        viewer_->governor().frameTime((float)Timer::instance().delta_s(frame_start, Timer::now()));
       }
     }
 
@@ -0,0 +1,78 @@
+#include <frustum.h>
+
+namespace Dental {
+  Frustum::Frustum() {
+    set(glm::mat4(1.f));
+  }
+
+  Frustum::Frustum(const glm::mat4& mvp) {
+    set(mvp);
+  }
+
+  void Frustum::set(const glm::mat4& mvp) {
+    // Gribb/Hartmann, 由裁剪空间的-w <= x, y, z <= w得到
+    glm::vec4 row[4];
+    for (int i = 0; i < 4; ++i) {
+      row[i] = glm::vec4(mvp[0][i], mvp[1][i], mvp[2][i], mvp[3][i]);
+    }
+
+    planes_[0] = row[3] + row[0];
+    planes_[1] = row[3] - row[0];
+    planes_[2] = row[3] + row[1];
+    planes_[3] = row[3] - row[1];
+    planes_[4] = row[3] + row[2];
+    planes_[5] = row[3] - row[2];
+
+    for (auto& plane : planes_) {
+      auto length = glm::length(glm::vec3(plane));
+      if (length > 0.f) {
+        plane /= length;
+      }
+    }
+  }
+
+  Frustum::Result Frustum::test(const BoundingSphere& sphere) const {
+    if (!sphere.valid()) {
+      return Result::INTERSECT;
+    }
+
+    auto result = Result::INSIDE;
+    for (auto& plane : planes_) {
+      auto distance = glm::dot(glm::vec3(plane), sphere.center()) + plane.w;
+      if (distance < -sphere.radius()) {
+        return Result::OUTSIDE;
+      }
+      if (distance < sphere.radius()) {
+        result = Result::INTERSECT;
+      }
+    }
+    return result;
+  }
+
+  Frustum::Result Frustum::test(const BoundingBox& box) const {
+    if (!box.valid()) {
+      return Result::INTERSECT;
+    }
+
+    auto result = Result::INSIDE;
+    for (auto& plane : planes_) {
+      // 沿法向最远和最近的两个角点
+      glm::vec3 positive = box.min();
+      glm::vec3 negative = box.max();
+      for (int i = 0; i < 3; ++i) {
+        if (plane[i] >= 0.f) {
+          positive[i] = box.max()[i];
+          negative[i] = box.min()[i];
+        }
+      }
+
+      if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.f) {
+        return Result::OUTSIDE;
+      }
+      if (glm::dot(glm::vec3(plane), negative) + plane.w < 0.f) {
+        result = Result::INTERSECT;
+      }
+    }
+    return result;
+  }
+}
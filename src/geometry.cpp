@@ -1,20 +1,46 @@
+#include <algorithm>
+#include <atomic>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/transform.hpp>
 #include <glm/gtx/euler_angles.hpp>
 #include <geometry.h>
+#include <node.h>
 #include <uuid.h>
 
+namespace {
+  // geometry可能在其他线程析构
+  std::atomic<std::size_t> total_released_bytes(0);
+
+  // 与上一个区间相邻时合并, 减少绘制次数
+  void appendRange(std::vector<std::pair<unsigned int, unsigned int>>& ranges, unsigned int first, unsigned int count) {
+    if (!ranges.empty() && ranges.back().first + ranges.back().second == first) {
+      ranges.back().second += count;
+    } else {
+      ranges.emplace_back(first, count);
+    }
+  }
+}
+
 namespace Dental {
   Geometry::Geometry() :
     mv_(glm::identity<glm::mat4>()),
     dirty_(true),
+    revision_(0),
     vertex_array_(std::make_shared<Vec3Array>()),
     normal_array_(std::make_shared<Vec3Array>()),
     color_array_(std::make_shared<Vec4Array>()),
     texcoord_array_(std::make_shared<Vec2Array>()),
     uuid_(createUUID()),
     dirty_bounding_(true),
-    render_technique_(std::make_shared<ShadowRenderTechnique>()) {
+    render_technique_(std::make_shared<ShadowRenderTechnique>()),
+    vertex_array_object_(std::make_shared<GLVertexArrayObject>()),
+    translucent_(false),
+    residency_(Residency::KEEP),
+    released_bytes_(0),
+    cluster_culling_(true),
+    lods_revision_(0),
+    lod_(0),
+    overlays_revision_(0) {
     vertex_array_->bind(static_cast<std::underlying_type<Attrib>::type>(Attrib::POSITION));
     normal_array_->bind(static_cast<std::underlying_type<Attrib>::type>(Attrib::NORMAL));
     color_array_->bind(static_cast<std::underlying_type<Attrib>::type>(Attrib::COLOR));
@@ -22,11 +48,12 @@ namespace Dental {
   }
 
   Geometry::~Geometry() {
-
+    total_released_bytes -= released_bytes_;
   }
 
   Geometry& Geometry::operator = (const Geometry& rhs) {
     if (this != &rhs) {
+      rhs.restore();
       parent_ = rhs.parent_;
       name_ = rhs.name_;
       mv_ = rhs.mv_;
@@ -35,6 +62,11 @@ namespace Dental {
       *color_array_ = *rhs.color_array_;
       *texcoord_array_ = *rhs.texcoord_array_;
 	    uuid_ = rhs.uuid_;
+
+      decltype(attrib_arrays_)().swap(attrib_arrays_);
+      for (const auto& itr : rhs.attrib_arrays_) {
+        attribArray(itr.first, itr.second->cloneArray());
+      }
       dirty_bounding_ = rhs.dirty_bounding_;
       bounding_sphere_ = rhs.bounding_sphere_;
 
@@ -42,19 +74,36 @@ namespace Dental {
       for (const auto& primitive_set : rhs.primitive_sets_) {
         primitive_sets_.emplace_back(primitive_set->clone());
       }
+      clusters(rhs.clusters_);
       
       decltype(textures_)().swap(textures_);
       for (const auto& itr : rhs.textures_) {
         textures_.insert({ itr.first, itr.second->clone() });
       }
+      translucent_ = rhs.translucent_;
+      residency_ = rhs.residency_;
       dirty();
       dirtyBounding();
+
+      // 数据相同, 简化层级和叠加图元依然有效; 层级只读, 可以共用
+      bool lods_valid = rhs.lodsValid();
+      bool overlays_valid = rhs.overlaysValid();
+      lods_ = lods_valid ? rhs.lods_ : decltype(lods_)();
+      lod_triangles_ = lods_valid ? rhs.lod_triangles_ : decltype(lod_triangles_)();
+      lods_revision_ = revision_;
+      lod_ = 0;
+
+      for (unsigned int i = 0; i < OVERLAY_COUNT; ++i) {
+        auto& primitive_set = rhs.overlays_[i];
+        overlay((Overlay)i, overlays_valid && primitive_set ? primitive_set->clone() : nullptr);
+      }
     }
     return *this;
   }
 
   Geometry& Geometry::operator = (Geometry&& rhs) noexcept {
     if (this != &rhs) {
+      rhs.restore();
       parent_ = std::move(rhs.parent_);
       name_ = std::move(rhs.name_);
       mv_ = std::move(rhs.mv_);
@@ -62,22 +111,37 @@ namespace Dental {
       *normal_array_ = std::move(*rhs.normal_array_);
       *color_array_ = std::move(*rhs.color_array_);
       *texcoord_array_ = std::move(*rhs.texcoord_array_);
+      attrib_arrays_ = std::move(rhs.attrib_arrays_);
       primitive_sets_ = std::move(rhs.primitive_sets_);
+      clusters(rhs.clusters_);
       textures_ = std::move(rhs.textures_);
 	    uuid_ = std::move(rhs.uuid_);
       dirty_bounding_ = std::move(rhs.dirty_bounding_);
       bounding_sphere_ = std::move(rhs.bounding_sphere_);
+      translucent_ = rhs.translucent_;
+      residency_ = rhs.residency_;
       dirty();
       dirtyBounding();
+
+      bool lods_valid = rhs.lodsValid();
+      bool overlays_valid = rhs.overlaysValid();
+      lods_ = lods_valid ? std::move(rhs.lods_) : decltype(lods_)();
+      lod_triangles_ = lods_valid ? std::move(rhs.lod_triangles_) : decltype(lod_triangles_)();
+      lods_revision_ = revision_;
+      lod_ = 0;
+
+      for (unsigned int i = 0; i < OVERLAY_COUNT; ++i) {
+        overlay((Overlay)i, overlays_valid ? std::move(rhs.overlays_[i]) : nullptr);
+      }
     }
     return *this;
   }
 
-  Geometry::Geometry(const Geometry& rhs) {
+  Geometry::Geometry(const Geometry& rhs) : Geometry() {
     *this = rhs;
   }
 
-  Geometry::Geometry(Geometry&& rhs) noexcept {
+  Geometry::Geometry(Geometry&& rhs) noexcept : Geometry() {
     *this = std::move(rhs);
   }
 
@@ -100,6 +164,7 @@ namespace Dental {
     mv_[3].x = origin.x;
     mv_[3].y = origin.y;
     mv_[3].z = origin.z;
+    dirtyBounding();
   }
 
   void Geometry::get_scale_rotate_translate(glm::vec3& scale, glm::quat& rotate, glm::vec3& translate) const {
@@ -118,14 +183,17 @@ namespace Dental {
 
   void Geometry::set_scale_rotate_translate(glm::vec3 scale, glm::quat rotate, glm::vec3 translate) {
     mv_ = glm::translate(translate) * glm::mat4_cast(rotate) * glm::scale(scale);
+    dirtyBounding();
   }
 
   void Geometry::translate(const glm::vec3& trans) {
     mv_ = glm::translate(mv_, trans);
+    dirtyBounding();
   }
 
    void Geometry::rotate(float angle, const glm::vec3& normal) {
      mv_ = glm::rotate(mv_, angle, normal);
+     dirtyBounding();
    }
 
   void Geometry::angle(const glm::vec3 angle) {
@@ -147,6 +215,7 @@ namespace Dental {
 
   void Geometry::set_scale(const glm::vec3 scale) {
     mv_ = glm::scale(mv_, scale);
+    dirtyBounding();
   }
 
   void Geometry::scale(const glm::vec3 scale) {
@@ -161,11 +230,56 @@ namespace Dental {
     return glm::vec3(glm::length(glm::vec3(mv_[0])), glm::length(glm::vec3(mv_[1])), glm::length(glm::vec3(mv_[2])));
   }
 
+  void Geometry::attribArray(unsigned int index, const ArrayBasePtr& array) {
+    array->bind(index);
+    attrib_arrays_[index] = array;
+    dirty();
+  }
+
+  ArrayBasePtr Geometry::attribArray(unsigned int index) const {
+    auto itr = attrib_arrays_.find(index);
+    return itr != attrib_arrays_.end() ? itr->second : nullptr;
+  }
+
+  void Geometry::removeAttribArray(unsigned int index) {
+    if (attrib_arrays_.erase(index)) {
+      dirty();
+    }
+  }
+
+  void Geometry::scalarArray(const FloatArrayPtr& array) {
+    if (array) {
+      attribArray((unsigned int)Attrib::SCALAR, array);
+    } else {
+      removeAttribArray((unsigned int)Attrib::SCALAR);
+    }
+  }
+
+  FloatArrayPtr Geometry::scalarArray() const {
+    return std::dynamic_pointer_cast<FloatArray>(attribArray((unsigned int)Attrib::SCALAR));
+  }
+
+  void Geometry::occlusionArray(const FloatArrayPtr& array) {
+    auto index = (unsigned int)Attrib::OCCLUSION;
+    if (array) {
+      array->bind(index);
+      attrib_arrays_[index] = array;
+      dirty_ = true;
+    } else if (attrib_arrays_.erase(index)) {
+      dirty_ = true;
+    }
+  }
+
+  FloatArrayPtr Geometry::occlusionArray() const {
+    return std::dynamic_pointer_cast<FloatArray>(attribArray((unsigned int)Attrib::OCCLUSION));
+  }
+
   void Geometry::addPrimitiveSet(const PrimitiveSetPtr& primitive_set) {
     primitive_sets_.emplace_back(primitive_set);
   }
 
   void Geometry::setPrimitiveSet(const PrimitiveSetPtr& primitive_set) {
+    clusters({});
     primitive_sets_.clear();
     primitive_sets_.emplace_back(primitive_set);
   }
@@ -179,16 +293,21 @@ namespace Dental {
 
   void Geometry::removePrimitiveSet(unsigned int index) {
     if (index < primitive_sets_.size()) {
+      if (index == 0) {
+        clusters({});
+      }
       primitive_sets_.erase(primitive_sets_.begin() + index);
     }
   }
 
   void Geometry::clearPrimitiveSets() {
+    clusters({});
     primitive_sets_.clear();
   }
 
   void Geometry::dirty() {
     dirty_ = true;
+    ++revision_;
   }
 
   void Geometry::texture(const TexturePtr& texture, unsigned int target) {
@@ -235,10 +354,20 @@ namespace Dental {
     color_array_->dirty();
     texcoord_array_->dirty();
 
+    for (auto& itr : attrib_arrays_) {
+      itr.second->dirty();
+    }
+
     for (auto& primitive_set : primitive_sets_) {
       primitive_set->dirty();
     }
 
+    for (auto& overlay : overlays_) {
+      if (overlay) {
+        overlay->dirty();
+      }
+    }
+
     for (auto& itr : textures_) {
       itr.second->bind(itr.first);
       itr.second->dirty();
@@ -247,22 +376,56 @@ namespace Dental {
 
   void Geometry::setupGLObjects() {
     decltype(gl_objects_)().swap(gl_objects_);
+    decltype(draw_objects_)().swap(draw_objects_);
+    element_buffer_ = nullptr;
 
+    translucent_ = false;
     for (auto& itr : textures_) {
       gl_objects_.emplace_back(itr.second->GLObject());
+
+      auto& image = itr.second->image();
+      translucent_ = translucent_ || (image && image->isImageTranslucent());
+    }
+
+    for (auto& color : *color_array_) {
+      if (color.a < 1.f) {
+        translucent_ = true;
+        break;
+      }
     }
 
-    gl_objects_.emplace_back(vertex_array_->GLObject());
-    gl_objects_.emplace_back(normal_array_->GLObject());
-    gl_objects_.emplace_back(color_array_->GLObject());
-    gl_objects_.emplace_back(texcoord_array_->GLObject());
+    vertex_array_object_->clear();
+    vertex_array_object_->addArray(std::dynamic_pointer_cast<GLBufferObject>(vertex_array_->GLObject()));
+    vertex_array_object_->addArray(std::dynamic_pointer_cast<GLBufferObject>(normal_array_->GLObject()));
+    vertex_array_object_->addArray(std::dynamic_pointer_cast<GLBufferObject>(color_array_->GLObject()));
+    vertex_array_object_->addArray(std::dynamic_pointer_cast<GLBufferObject>(texcoord_array_->GLObject()));
+
+    for (auto& itr : attrib_arrays_) {
+      vertex_array_object_->addArray(std::dynamic_pointer_cast<GLBufferObject>(itr.second->GLObject()));
+    }
 
     for (auto& primitive_set : primitive_sets_) {
-      gl_objects_.emplace_back(primitive_set->GLObject());
+      auto object = primitive_set->GLObject();
+      // 第一个索引缓冲记录在VAO中, 绘制时不再绑定
+      if (!element_buffer_) {
+        element_buffer_ = std::dynamic_pointer_cast<GLElementBufferObject>(object);
+        if (element_buffer_) {
+          vertex_array_object_->elements(element_buffer_);
+        }
+      }
+      draw_objects_.emplace_back(object);
     }
   }
 
   BoundingBox Geometry::boundingBox() const {
+    return localBox();
+  }
+
+  BoundingBox Geometry::localBox() const {
+    if (!resident()) {
+      return released_box_;
+    }
+
     BoundingBox box;
     for (auto& vertex : *vertex_array_) {
       box.expandBy({ vertex.x, vertex.y, vertex.z });
@@ -270,18 +433,209 @@ namespace Dental {
     return box;
   }
 
+  void Geometry::releaseData() {
+    released_box_ = localBox();
+
+    std::size_t bytes = 0;
+    bytes += vertex_array_->releaseData();
+    bytes += normal_array_->releaseData();
+    bytes += color_array_->releaseData();
+    bytes += texcoord_array_->releaseData();
+
+    for (auto& itr : attrib_arrays_) {
+      bytes += itr.second->releaseData();
+    }
+
+    for (auto& primitive_set : primitive_sets_) {
+      bytes += primitive_set->releaseData();
+    }
+
+    released_bytes_ = bytes;
+    total_released_bytes += bytes;
+  }
+
+  bool Geometry::restore() const {
+    if (resident()) {
+      return true;
+    }
+
+    bool restored = vertex_array_->restoreData() &&
+      normal_array_->restoreData() &&
+      color_array_->restoreData() &&
+      texcoord_array_->restoreData();
+
+    for (auto& itr : attrib_arrays_) {
+      restored = restored && itr.second->restoreData();
+    }
+
+    for (auto& primitive_set : primitive_sets_) {
+      restored = restored && primitive_set->restoreData();
+    }
+
+    if (restored) {
+      total_released_bytes -= released_bytes_;
+      released_bytes_ = 0;
+    }
+    return restored;
+  }
+
+  std::size_t Geometry::totalReleasedBytes() {
+    return total_released_bytes;
+  }
+
   void Geometry::render() {
     if (dirty_) {
+      // 重新上传前先读回释放的数据
+      restore();
       dirtyGLObjects();
       setupGLObjects();
       dirty_ = false;
     }
 
-    gl_objects_.render();
+    gl_objects_.bind();
+    vertex_array_object_->bind();
+
+    // 大模型的缓冲分多帧上传, 上传完之前不绘制
+    if (vertex_array_object_->ready()) {
+      drawPrimitives();
+
+      if (residency_ == Residency::RELEASE_AFTER_UPLOAD && resident()) {
+        releaseData();
+      }
+    }
+
+    vertex_array_object_->unbind();
+    gl_objects_.unbind();
+  }
+
+  void Geometry::clusters(const Clusters& clusters) {
+    clusters_ = clusters;
+    uncullClusters();
+  }
+
+  unsigned int Geometry::cullClusters(const Frustum& frustum, const glm::vec3& eye, bool perspective) {
+    visible_ranges_.clear();
+
+    unsigned int visible = 0;
+    for (const auto& cluster : clusters_) {
+      if (frustum.test(cluster.sphere) == Frustum::Result::OUTSIDE) {
+        continue;
+      }
+
+      // 法向锥整体背向视点时, 簇内所有三角形都是背面
+      if (cluster.cutoff <= 1.f) {
+        if (perspective) {
+          auto offset = cluster.sphere.center() - eye;
+          if (glm::dot(offset, cluster.axis) >= cluster.cutoff * glm::length(offset) + cluster.sphere.radius()) {
+            continue;
+          }
+        } else if (glm::dot(eye, cluster.axis) >= cluster.cutoff) {
+          continue;
+        }
+      }
+
+      ++visible;
+      appendRange(visible_ranges_, cluster.first, cluster.count);
+    }
+
+    return visible;
+  }
+
+  void Geometry::uncullClusters() {
+    visible_ranges_.clear();
+    for (const auto& cluster : clusters_) {
+      appendRange(visible_ranges_, cluster.first, cluster.count);
+    }
+  }
+
+  void Geometry::lods(const std::vector<GeometryPtr>& lods, unsigned int triangles) {
+    lods_ = lods;
+    lod_triangles_.assign(1, triangles);
+    for (auto& lod : lods_) {
+      lod_triangles_.emplace_back(lod->primitiveSet() ? lod->primitiveSet()->numPrimitives() : 0);
+    }
+    lods_revision_ = revision_;
+    lod_ = 0;
+  }
+
+  void Geometry::overlay(Overlay overlay, const PrimitiveSetPtr& primitive_set) {
+    // 索引在第一次绘制时上传, 不需要重新设置其他GL对象
+    if (primitive_set) {
+      primitive_set->dirty();
+    }
+    overlays_[(unsigned int)overlay] = primitive_set;
+    overlays_revision_ = revision_;
+  }
+
+  PrimitiveSetPtr Geometry::overlay(Overlay overlay) const {
+    return overlays_[(unsigned int)overlay];
+  }
+
+  bool Geometry::overlaysValid() const {
+    if (overlays_revision_ != revision_) {
+      return false;
+    }
+
+    for (auto& overlay : overlays_) {
+      if (overlay) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void Geometry::renderOverlay(Overlay overlay) {
+    auto& primitive_set = overlays_[(unsigned int)overlay];
+    if (dirty_ || !primitive_set || !primitive_set->numIndices()) {
+      return;
+    }
+
+    vertex_array_object_->bind();
+    if (vertex_array_object_->ready()) {
+      // 绑定会替换VAO中记录的索引缓冲, 绘制后恢复
+      primitive_set->GLObject()->bind();
+      if (element_buffer_) {
+        element_buffer_->sync();
+      }
+    }
+    vertex_array_object_->unbind();
+  }
+
+  Geometry& Geometry::lodGeometry(unsigned int level) {
+    if (!level || !lodsValid()) {
+      return *this;
+    }
+    return *lods_[std::min<std::size_t>(level, lods_.size()) - 1];
+  }
+
+  void Geometry::drawPrimitives() {
+    bool rebind_elements = false;
+    for (auto& object : draw_objects_) {
+      if (object == element_buffer_ && !clusters_.empty() && cluster_culling_) {
+        for (auto& range : visible_ranges_) {
+          element_buffer_->draw(range.first, range.second);
+        }
+      } else if (object == element_buffer_) {
+        element_buffer_->draw();
+      } else {
+        object->bind();
+        rebind_elements = true;
+      }
+    }
+
+    // 其他DrawElements会替换VAO中记录的索引缓冲
+    if (rebind_elements && element_buffer_) {
+      element_buffer_->sync();
+    }
   }
 
   void Geometry::dirtyBounding() {
     dirty_bounding_ = true;
+
+    // 节点的包围球由所有geometry合并而成
+    if (auto node = parent_.lock()) {
+      node->dirtyBounding();
+    }
   }
 
   void Geometry::computeBounding() {
@@ -297,13 +651,12 @@ namespace Dental {
 
     bounding_sphere_.init();
 
-    if (vertex_array_->empty()) {
+    BoundingBox box = localBox();
+    bounding_box_ = box;
+    if (!box.valid()) {
       return;
     }
 
-    BoundingBox box;
-    box.expandBy(vertex_array_);
-
     glm::vec4 min = mv_ * glm::vec4(box.min(), 1.f);
     glm::vec4 max = mv_ * glm::vec4(box.max(), 1.f);
 
@@ -311,6 +664,11 @@ namespace Dental {
     bounding_sphere_.expandBy(glm::vec3(max / max.w));
   }
 
+  const BoundingBox& Geometry::localBoundingBox() {
+    boundingSphere();
+    return bounding_box_;
+  }
+
   BoundingSphere &Geometry::boundingSphere() {
     if (dirty_bounding_) {
       computeBounding();
@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <cstring>
+#include <gl_buffer_object.h>
+#include <gl_state.h>
+#include <gl_delete_queue.h>
+#include <upload_scheduler.h>
+
+namespace {
+  // 局部更新达到该次数后改用GL_DYNAMIC_DRAW重新分配
+  const unsigned int DYNAMIC_UPLOAD_THRESHOLD = 8;
+}
+
+namespace Dental {
+  GLBufferObject::GLBufferObject(GLenum target, short data_type_size) :
+    target_(target),
+    data_type_size_(data_type_size),
+    buffer_(0),
+    buffer_size_(0),
+    streamed_(0),
+    data_size_(0),
+    data_(nullptr),
+    dirty_(true),
+    scheduled_(true),
+    usage_(GL_STATIC_DRAW),
+    partial_uploads_(0) {
+  }
+
+  void GLBufferObject::bindData(GLsizeiptr data_size, void* data) {
+    data_size_ = data_size;
+    data_ = data;
+  }
+
+  void GLBufferObject::dirtyRange(GLsizeiptr first, GLsizeiptr count) {
+    if (dirty_ || count <= 0 || first >= data_size_) {
+      return;
+    }
+
+    GLsizeiptr last = std::min(first + count, data_size_);
+    first = std::max<GLsizeiptr>(first, 0);
+
+    auto itr = std::lower_bound(ranges_.begin(), ranges_.end(), std::make_pair(first, last));
+    itr = ranges_.emplace(itr, first, last);
+
+    // 与前后相交或相邻的区间合并
+    if (itr != ranges_.begin() && std::prev(itr)->second >= itr->first) {
+      auto prev = std::prev(itr);
+      prev->second = std::max(prev->second, itr->second);
+      itr = std::prev(ranges_.erase(itr));
+    }
+
+    auto next = std::next(itr);
+    while (next != ranges_.end() && next->first <= itr->second) {
+      itr->second = std::max(itr->second, next->second);
+      next = ranges_.erase(next);
+    }
+
+    GLsizeiptr total = 0;
+    for (auto& range : ranges_) {
+      total += range.second - range.first;
+    }
+
+    if (total * 2 >= data_size_) {
+      dirty();
+    }
+  }
+
+  void GLBufferObject::upload() {
+    if (!buffer_) {
+      glGenBuffers(1, &buffer_);
+      dirty_ = true;
+    }
+
+    if (!buffer_) {
+      return;
+    }
+
+    // 索引缓冲绑定到VAO, 数据释放后也要绑定
+    GLState::instance().bindBuffer(target_, buffer_);
+
+    // 数据已释放, GL缓冲中的内容依然有效
+    if (!data_) {
+      return;
+    }
+
+    if (dirty_ || buffer_size_ != data_size_) {
+      auto bytes = data_size_ * data_type_size_;
+      auto granted = scheduled_ ? UploadScheduler::instance().acquire(bytes, data_type_size_) : bytes;
+
+      // 预算足够时一次上传, 否则先分配, 之后每帧填充一部分
+      glBufferData(target_, bytes, granted == bytes ? data_ : nullptr, usage_);
+      if (granted > 0 && granted < bytes) {
+        glBufferSubData(target_, 0, granted, data_);
+      }
+
+      buffer_size_ = data_size_;
+      streamed_ = granted / data_type_size_;
+      dirty_ = false;
+      ranges_.clear();
+      return;
+    }
+
+    if (streamed_ < buffer_size_) {
+      stream();
+      // 分帧上传期间的局部更新等全部上传后再提交
+      if (streamed_ < buffer_size_) {
+        return;
+      }
+    }
+
+    if (ranges_.empty()) {
+      return;
+    }
+
+    for (auto& range : ranges_) {
+      glBufferSubData(target_, range.first * data_type_size_,
+                      (range.second - range.first) * data_type_size_,
+                      (const char*)data_ + range.first * data_type_size_);
+    }
+    ranges_.clear();
+
+    if (usage_ == GL_STATIC_DRAW && ++partial_uploads_ >= DYNAMIC_UPLOAD_THRESHOLD) {
+      usage_ = GL_DYNAMIC_DRAW;
+      dirty();
+    }
+  }
+
+  void GLBufferObject::stream() {
+    auto offset = streamed_ * data_type_size_;
+    auto granted = UploadScheduler::instance().acquire((buffer_size_ - streamed_) * data_type_size_, data_type_size_);
+    if (granted <= 0) {
+      return;
+    }
+
+    glBufferSubData(target_, offset, granted, (const char*)data_ + offset);
+    streamed_ += granted / data_type_size_;
+  }
+
+  bool GLBufferObject::read(void* data) const {
+    if (!buffer_ || !data_size_ || buffer_size_ != data_size_ || streamed_ < buffer_size_) {
+      return false;
+    }
+
+    // 使用GL_COPY_READ_BUFFER, 不改变VAO中记录的索引缓冲
+    auto bytes = data_size_ * data_type_size_;
+    GLState::instance().bindBuffer(GL_COPY_READ_BUFFER, buffer_);
+    void* mapped = glMapBufferRange(GL_COPY_READ_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+    if (mapped) {
+      std::memcpy(data, mapped, bytes);
+      glUnmapBuffer(GL_COPY_READ_BUFFER);
+    }
+    GLState::instance().bindBuffer(GL_COPY_READ_BUFFER, 0);
+    return mapped != nullptr;
+  }
+
+  void GLBufferObject::sync() {
+    if (!data_size_) {
+      dirty_ = false;
+      return;
+    }
+
+    upload();
+  }
+
+  void GLBufferObject::bind() {
+    sync();
+  }
+
+  void GLBufferObject::unbind() {
+    GLState::instance().bindBuffer(target_, 0);
+  }
+
+  void GLBufferObject::release() {
+    if (buffer_) {
+      GLDeleteQueue::instance().push(GLDeleteQueue::Type::BUFFER, buffer_);
+      buffer_ = 0;
+      buffer_size_ = 0;
+      streamed_ = 0;
+    }
+  }
+
+  void GLBufferObject::dirty() {
+    dirty_ = true;
+    ranges_.clear();
+  }
+
+  bool GLBufferObject::valid() {
+    return !dirty_ && ranges_.empty() && data_size_ && buffer_ != 0 && streamed_ >= buffer_size_;
+  }
+}
@@ -0,0 +1,91 @@
+#include <gl_delete_queue.h>
+#include <gl_state.h>
+
+namespace Dental {
+  GLDeleteQueue::GLDeleteQueue() :
+    deleted_(0) {
+  }
+
+  GLDeleteQueue& GLDeleteQueue::instance() {
+    // 不析构, 退出时其他静态对象的析构函数依然可以入队
+    static GLDeleteQueue* queue = new GLDeleteQueue();
+    return *queue;
+  }
+
+  void GLDeleteQueue::push(Type type, unsigned int name) {
+    if (!name) {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    names_[static_cast<std::size_t>(type)].emplace_back(name);
+  }
+
+  std::size_t GLDeleteQueue::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t count = 0;
+    for (auto& names : names_) {
+      count += names.size();
+    }
+    return count;
+  }
+
+  void GLDeleteQueue::flush() {
+    Names names;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      names.swap(names_);
+    }
+
+    auto& state = GLState::instance();
+    deleted_ = 0;
+
+    auto& buffers = names[static_cast<std::size_t>(Type::BUFFER)];
+    if (!buffers.empty()) {
+      for (auto name : buffers) {
+        state.forgetBuffer(name);
+      }
+      glDeleteBuffers((GLsizei)buffers.size(), buffers.data());
+      deleted_ += buffers.size();
+    }
+
+    auto& vertex_arrays = names[static_cast<std::size_t>(Type::VERTEX_ARRAY)];
+    if (!vertex_arrays.empty()) {
+      for (auto name : vertex_arrays) {
+        state.forgetVertexArray(name);
+      }
+      glDeleteVertexArrays((GLsizei)vertex_arrays.size(), vertex_arrays.data());
+      deleted_ += vertex_arrays.size();
+    }
+
+    auto& textures = names[static_cast<std::size_t>(Type::TEXTURE)];
+    if (!textures.empty()) {
+      for (auto name : textures) {
+        state.forgetTexture(name);
+      }
+      glDeleteTextures((GLsizei)textures.size(), textures.data());
+      deleted_ += textures.size();
+    }
+
+    auto& framebuffers = names[static_cast<std::size_t>(Type::FRAMEBUFFER)];
+    if (!framebuffers.empty()) {
+      for (auto name : framebuffers) {
+        state.forgetFramebuffer(name);
+      }
+      glDeleteFramebuffers((GLsizei)framebuffers.size(), framebuffers.data());
+      deleted_ += framebuffers.size();
+    }
+
+    auto& renderbuffers = names[static_cast<std::size_t>(Type::RENDERBUFFER)];
+    if (!renderbuffers.empty()) {
+      glDeleteRenderbuffers((GLsizei)renderbuffers.size(), renderbuffers.data());
+      deleted_ += renderbuffers.size();
+    }
+
+    for (auto name : names[static_cast<std::size_t>(Type::PROGRAM)]) {
+      state.forgetProgram(name);
+      glDeleteProgram(name);
+      ++deleted_;
+    }
+  }
+}
@@ -1,6 +1,8 @@
 #include <glad/glad.h>
 #include <vector>
 #include <gl_frame_buffer.h>
+#include <gl_state.h>
+#include <gl_delete_queue.h>
 
 namespace Dental {
   GLFrameBuffer::GLFrameBuffer() :
@@ -13,16 +15,16 @@ namespace Dental {
     if (fbo_ == 0) {
       glGenFramebuffers(1, &fbo_);
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    GLState::instance().bindFramebuffer(GL_FRAMEBUFFER, fbo_);
   }
 
   void GLFrameBuffer::unbind() {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLState::instance().bindFramebuffer(GL_FRAMEBUFFER, 0);
   }
 
   void GLFrameBuffer::release() {
     if (fbo_) {
-      glDeleteFramebuffers(1, &fbo_);
+      GLDeleteQueue::instance().push(GLDeleteQueue::Type::FRAMEBUFFER, fbo_);
       fbo_ = 0;
     }
   }
@@ -56,6 +58,14 @@ namespace Dental {
   }
 
   void GLFrameBuffer::blit(
+    int x, int y,
+    unsigned int width, unsigned int height, unsigned int color_attachment) const {
+    blit(0, 0, width_, height_, x, y, width, height, color_attachment);
+  }
+
+  void GLFrameBuffer::blit(
+    int src_x, int src_y,
+    unsigned int src_width, unsigned int src_height,
     int x, int y,
     unsigned int width, unsigned int height, unsigned int color_attachment) const {
     auto itr = colors_.find(color_attachment);
@@ -63,17 +73,21 @@ namespace Dental {
       return;
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    GLState::instance().bindFramebuffer(GL_FRAMEBUFFER, fbo_);
     glBindRenderbuffer(GL_RENDERBUFFER, itr->second);
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo_);
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    GLState::instance().bindFramebuffer(GL_READ_FRAMEBUFFER, fbo_);
+    GLState::instance().bindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 
-    glBlitFramebuffer(0, 0, width_, height_, x, y, x + width, y + height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
-    glBlitFramebuffer(0, 0, width_, height_, x, y, x + width, y + height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    // 尺寸不同时颜色线性插值, 深度只能按最近点拷贝
+    GLenum filter = (src_width == width && src_height == height) ? GL_NEAREST : GL_LINEAR;
+    glBlitFramebuffer(src_x, src_y, src_x + src_width, src_y + src_height,
+                      x, y, x + width, y + height, GL_COLOR_BUFFER_BIT, filter);
+    glBlitFramebuffer(src_x, src_y, src_x + src_width, src_y + src_height,
+                      x, y, x + width, y + height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
 
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLState::instance().bindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    GLState::instance().bindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    GLState::instance().bindFramebuffer(GL_FRAMEBUFFER, 0);
   }
 
   GLFrameRenderBuffer::GLFrameRenderBuffer() : GLFrameBuffer(),
@@ -138,13 +152,13 @@ namespace Dental {
     GLFrameBuffer::release();
 
     if (depth_) {
-      glDeleteRenderbuffers(1, &depth_);
+      GLDeleteQueue::instance().push(GLDeleteQueue::Type::RENDERBUFFER, depth_);
       depth_ = 0;
     }
 
     for (auto& itr : colors_) {
       if (itr.second) {
-        glDeleteRenderbuffers(1, &itr.second);
+        GLDeleteQueue::instance().push(GLDeleteQueue::Type::RENDERBUFFER, itr.second);
         itr.second = 0;
       }
     }
@@ -156,15 +170,15 @@ namespace Dental {
   }
 
   void GLFrameRenderBuffer::unbind() {
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo_);
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    GLState::instance().bindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    GLState::instance().bindFramebuffer(GL_READ_FRAMEBUFFER, fbo_);
+    GLState::instance().bindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 
     glBlitFramebuffer(0, 0, width_, height_, 0, 0, width_, height_, GL_COLOR_BUFFER_BIT, GL_NEAREST);
     glBlitFramebuffer(0, 0, width_, height_, 0, 0, width_, height_, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
 
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    GLState::instance().bindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    GLState::instance().bindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
   }
 
   GLFrameTextureBuffer::GLFrameTextureBuffer() : GLFrameBuffer() {
@@ -179,7 +193,7 @@ namespace Dental {
     if (!fbo_) {
       if (depth_ == 0) {
         glGenTextures(1, &depth_);
-        glBindTexture(GL_TEXTURE_2D, depth_);
+        GLState::instance().bindTexture(depth_);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width_, height_, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -188,14 +202,14 @@ namespace Dental {
       for (auto& itr : colors_) {
         if (itr.second == 0) {
           glGenTextures(1, &(itr.second));
-          glBindTexture(GL_TEXTURE_2D, itr.second);
+          GLState::instance().bindTexture(itr.second);
           glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width_, height_, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
           glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
           glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         }
       }
 
-      glBindTexture(GL_TEXTURE_2D, 0);
+      GLState::instance().bindTexture(0);
 
       GLFrameBuffer::bind();
 
@@ -217,13 +231,13 @@ namespace Dental {
     GLFrameBuffer::release();
 
     if (depth_) {
-      glDeleteTextures(1, &depth_);
+      GLDeleteQueue::instance().push(GLDeleteQueue::Type::TEXTURE, depth_);
       depth_ = 0;
     }
 
     for (auto& itr : colors_) {
       if (itr.second) {
-        glDeleteTextures(1, &itr.second);
+        GLDeleteQueue::instance().push(GLDeleteQueue::Type::TEXTURE, itr.second);
         itr.second = 0;
       }
     }
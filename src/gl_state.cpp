@@ -0,0 +1,222 @@
+#include <gl_state.h>
+
+namespace {
+  const unsigned int UNKNOWN = 0xffffffff;
+}
+
+namespace Dental {
+  GLState::GLState() {
+    statistics_ = { 0, 0 };
+    invalidate();
+  }
+
+  GLState& GLState::instance() {
+    static GLState state;
+    return state;
+  }
+
+  void GLState::invalidate() {
+    program_ = UNKNOWN;
+    vertex_array_ = UNKNOWN;
+    active_texture_ = UNKNOWN;
+    read_framebuffer_ = UNKNOWN;
+    draw_framebuffer_ = UNKNOWN;
+
+    buffers_.clear();
+    indexed_buffers_.clear();
+    textures_.clear();
+
+    viewport_valid_ = false;
+
+    capabilities_.clear();
+    blend_src_ = UNKNOWN;
+    blend_dst_ = UNKNOWN;
+  }
+
+  bool GLState::skip(bool same) {
+    if (same) {
+      ++statistics_.skipped;
+    } else {
+      ++statistics_.calls;
+    }
+    return same;
+  }
+
+  void GLState::useProgram(unsigned int program) {
+    if (skip(program_ == program)) {
+      return;
+    }
+    glUseProgram(program);
+    program_ = program;
+  }
+
+  void GLState::bindVertexArray(unsigned int vertex_array) {
+    if (skip(vertex_array_ == vertex_array)) {
+      return;
+    }
+    glBindVertexArray(vertex_array);
+    vertex_array_ = vertex_array;
+
+    // 索引缓冲的绑定属于VAO
+    buffers_.erase(GL_ELEMENT_ARRAY_BUFFER);
+  }
+
+  void GLState::bindBuffer(GLenum target, unsigned int buffer) {
+    auto itr = buffers_.find(target);
+    if (skip(itr != buffers_.end() && itr->second == buffer)) {
+      return;
+    }
+    glBindBuffer(target, buffer);
+    buffers_[target] = buffer;
+  }
+
+  void GLState::bindBufferBase(GLenum target, unsigned int index, unsigned int buffer) {
+    auto itr = indexed_buffers_.find({ target, index });
+    if (skip(itr != indexed_buffers_.end() && itr->second == buffer)) {
+      return;
+    }
+    glBindBufferBase(target, index, buffer);
+    indexed_buffers_[{ target, index }] = buffer;
+    // glBindBufferBase同时修改通用绑定点
+    buffers_[target] = buffer;
+  }
+
+  void GLState::activeTexture(unsigned int unit) {
+    if (skip(active_texture_ == unit)) {
+      return;
+    }
+    glActiveTexture(GL_TEXTURE0 + unit);
+    active_texture_ = unit;
+  }
+
+  void GLState::bindTexture(unsigned int texture) {
+    if (active_texture_ == UNKNOWN) {
+      activeTexture(0);
+    }
+    bindTexture(active_texture_, texture);
+  }
+
+  void GLState::bindTexture(unsigned int unit, unsigned int texture) {
+    if (unit >= textures_.size()) {
+      textures_.resize(unit + 1, UNKNOWN);
+    }
+
+    // 之后的glTexParameteri和glTexImage2D作用于激活的单元, 绑定相同也要切换
+    activeTexture(unit);
+    if (skip(textures_[unit] == texture)) {
+      return;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+    textures_[unit] = texture;
+  }
+
+  void GLState::bindFramebuffer(GLenum target, unsigned int framebuffer) {
+    bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+    bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+
+    if (skip((!read || read_framebuffer_ == framebuffer) && (!draw || draw_framebuffer_ == framebuffer))) {
+      return;
+    }
+    glBindFramebuffer(target, framebuffer);
+
+    if (read) {
+      read_framebuffer_ = framebuffer;
+    }
+    if (draw) {
+      draw_framebuffer_ = framebuffer;
+    }
+  }
+
+  unsigned int GLState::drawFramebuffer() {
+    if (draw_framebuffer_ == UNKNOWN) {
+      GLint framebuffer = 0;
+      glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+      draw_framebuffer_ = (unsigned int)framebuffer;
+    }
+    return draw_framebuffer_;
+  }
+
+  void GLState::viewport(int x, int y, int width, int height) {
+    glm::ivec4 viewport(x, y, width, height);
+    if (skip(viewport_valid_ && viewport_ == viewport)) {
+      return;
+    }
+    glViewport(x, y, width, height);
+    viewport_ = viewport;
+    viewport_valid_ = true;
+  }
+
+  void GLState::enable(GLenum capability) {
+    auto itr = capabilities_.find(capability);
+    if (skip(itr != capabilities_.end() && itr->second)) {
+      return;
+    }
+    glEnable(capability);
+    capabilities_[capability] = true;
+  }
+
+  void GLState::disable(GLenum capability) {
+    auto itr = capabilities_.find(capability);
+    if (skip(itr != capabilities_.end() && !itr->second)) {
+      return;
+    }
+    glDisable(capability);
+    capabilities_[capability] = false;
+  }
+
+  void GLState::blendFunc(GLenum src, GLenum dst) {
+    if (skip(blend_src_ == src && blend_dst_ == dst)) {
+      return;
+    }
+    glBlendFunc(src, dst);
+    blend_src_ = src;
+    blend_dst_ = dst;
+  }
+
+  void GLState::forgetProgram(unsigned int program) {
+    if (program_ == program) {
+      program_ = UNKNOWN;
+    }
+  }
+
+  void GLState::forgetVertexArray(unsigned int vertex_array) {
+    if (vertex_array_ == vertex_array) {
+      vertex_array_ = 0;
+      buffers_.erase(GL_ELEMENT_ARRAY_BUFFER);
+    }
+  }
+
+  void GLState::forgetBuffer(unsigned int buffer) {
+    for (auto& itr : buffers_) {
+      if (itr.second == buffer) {
+        itr.second = 0;
+      }
+    }
+    for (auto& itr : indexed_buffers_) {
+      if (itr.second == buffer) {
+        itr.second = 0;
+      }
+    }
+  }
+
+  void GLState::forgetTexture(unsigned int texture) {
+    for (auto& itr : textures_) {
+      if (itr == texture) {
+        itr = 0;
+      }
+    }
+  }
+
+  void GLState::forgetFramebuffer(unsigned int framebuffer) {
+    if (read_framebuffer_ == framebuffer) {
+      read_framebuffer_ = 0;
+    }
+    if (draw_framebuffer_ == framebuffer) {
+      draw_framebuffer_ = 0;
+    }
+  }
+
+  void GLState::resetStatistics() {
+    statistics_ = { 0, 0 };
+  }
+}
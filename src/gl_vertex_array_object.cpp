@@ -0,0 +1,109 @@
+#include <gl_vertex_array_object.h>
+#include <gl_state.h>
+#include <gl_delete_queue.h>
+
+namespace Dental {
+  GLVertexArrayObject::GLVertexArrayObject() :
+    vao_(0),
+    dirty_(true) {
+  }
+
+  void GLVertexArrayObject::addArray(const GLBufferObjectPtr& array) {
+    arrays_.emplace_back(array);
+    dirty_ = true;
+  }
+
+  void GLVertexArrayObject::elements(const GLBufferObjectPtr& elements) {
+    elements_ = elements;
+    dirty_ = true;
+  }
+
+  void GLVertexArrayObject::clear() {
+    decltype(arrays_)().swap(arrays_);
+    elements_ = nullptr;
+    dirty_ = true;
+  }
+
+  void GLVertexArrayObject::build() {
+    for (auto& array : arrays_) {
+      // 先关闭属性, 空数组不会重新开启
+      array->unbind();
+      array->bind();
+    }
+
+    if (elements_) {
+      elements_->sync();
+    }
+
+    GLState::instance().bindBuffer(GL_ARRAY_BUFFER, 0);
+    dirty_ = false;
+  }
+
+  void GLVertexArrayObject::bind() {
+    if (!vao_) {
+      glGenVertexArrays(1, &vao_);
+      dirty_ = true;
+    }
+
+    if (!vao_) {
+      return;
+    }
+
+    GLState::instance().bindVertexArray(vao_);
+
+    // 新创建的缓冲还没有记录在VAO中
+    for (auto itr = arrays_.begin(); !dirty_ && itr != arrays_.end(); ++itr) {
+      if ((*itr)->pending() && !(*itr)->id()) {
+        dirty_ = true;
+      }
+    }
+
+    if (elements_ && elements_->pending() && !elements_->id()) {
+      dirty_ = true;
+    }
+
+    if (dirty_) {
+      build();
+      return;
+    }
+
+    for (auto& array : arrays_) {
+      if (array->pending()) {
+        array->sync();
+      }
+    }
+
+    if (elements_ && elements_->pending()) {
+      elements_->sync();
+    }
+  }
+
+  void GLVertexArrayObject::unbind() {
+    GLState::instance().bindVertexArray(0);
+  }
+
+  void GLVertexArrayObject::release() {
+    if (vao_) {
+      GLDeleteQueue::instance().push(GLDeleteQueue::Type::VERTEX_ARRAY, vao_);
+      vao_ = 0;
+    }
+    dirty_ = true;
+  }
+
+  void GLVertexArrayObject::dirty() {
+    dirty_ = true;
+  }
+
+  bool GLVertexArrayObject::ready() const {
+    for (auto& array : arrays_) {
+      if (array->streaming()) {
+        return false;
+      }
+    }
+    return !elements_ || !elements_->streaming();
+  }
+
+  bool GLVertexArrayObject::valid() {
+    return vao_ != 0 && !dirty_;
+  }
+}
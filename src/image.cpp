@@ -1,5 +1,7 @@
 #include <algorithm>
 #include <image.h>
+#include <gl_state.h>
+#include <gl_delete_queue.h>
 #include <glad/glad.h>
 
 namespace {
@@ -130,7 +132,7 @@ namespace Dental {
 
   void Image::release() {
     if (texture_id_) {
-      glDeleteTextures(1, &texture_id_);
+      GLDeleteQueue::instance().push(GLDeleteQueue::Type::TEXTURE, texture_id_);
       texture_id_ = 0;
     }
   }
@@ -149,7 +151,7 @@ namespace Dental {
     if (!texture_id_) {
       glGenTextures(1, &texture_id_);
       if (texture_id_) {
-        glBindTexture(GL_TEXTURE_2D, texture_id_);
+        GLState::instance().bindTexture(texture_id_);
 
         GLint alignment;
         glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
@@ -162,7 +164,7 @@ namespace Dental {
         glGenerateMipmap(GL_TEXTURE_2D);
 
         glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        GLState::instance().bindTexture(0);
 
         deallocateData();
       }
@@ -0,0 +1,126 @@
+#include <instanced_geometry.h>
+
+namespace Dental {
+  InstancedGeometry::InstancedGeometry(const GeometryPtr& source) : Geometry(),
+    source_(source),
+    transform_array_(std::make_shared<Mat4Array>()),
+    instance_color_array_(std::make_shared<Vec4Array>()) {
+    name_ = source->name();
+    mv_ = glm::identity<glm::mat4>();
+
+    // 顶点数组和图元直接共享, 缓冲只上传一份
+    vertex_array_ = source->vertexArray();
+    normal_array_ = source->normalArray();
+    color_array_ = source->colorArray();
+    texcoord_array_ = source->texcoordArray();
+    attrib_arrays_ = source->attribArrays();
+
+    for (unsigned int i = 0; i < source->numPrimitiveSets(); ++i) {
+      primitive_sets_.emplace_back(source->primitiveSet(i));
+    }
+    textures_ = source->textures();
+
+    transform_array_->divisor(1);
+    instance_color_array_->divisor(1);
+    attribArray(static_cast<std::underlying_type<Attrib>::type>(Attrib::INSTANCE_TRANSFORM), transform_array_);
+    attribArray(static_cast<std::underlying_type<Attrib>::type>(Attrib::INSTANCE_COLOR), instance_color_array_);
+
+    // 沿用源geometry的technique, 不支持实例变体时保留默认的technique
+    auto& technique = source->renderTechnique();
+    if (technique && technique->supports(ProgramVariant::INSTANCED)) {
+      renderTechnique(technique);
+    }
+  }
+
+  unsigned int InstancedGeometry::addInstance(const glm::mat4& transform, const glm::vec4& color) {
+    transform_array_->emplace_back(transform);
+    instance_color_array_->emplace_back(color);
+    transform_array_->dirty();
+    instance_color_array_->dirty();
+    dirtyBounding();
+    return numInstances() - 1;
+  }
+
+  void InstancedGeometry::removeInstance(unsigned int index) {
+    if (index >= numInstances()) {
+      return;
+    }
+
+    transform_array_->erase(transform_array_->begin() + index);
+    instance_color_array_->erase(instance_color_array_->begin() + index);
+    transform_array_->dirty();
+    instance_color_array_->dirty();
+    dirtyBounding();
+  }
+
+  void InstancedGeometry::clearInstances() {
+    transform_array_->clear();
+    instance_color_array_->clear();
+    dirtyBounding();
+  }
+
+  void InstancedGeometry::transform(unsigned int index, const glm::mat4& transform) {
+    if (index >= numInstances()) {
+      return;
+    }
+
+    (*transform_array_)[index] = transform;
+    transform_array_->dirty(index, 1);
+    dirtyBounding();
+  }
+
+  void InstancedGeometry::color(unsigned int index, const glm::vec4& color) {
+    if (index >= numInstances()) {
+      return;
+    }
+
+    (*instance_color_array_)[index] = color;
+    instance_color_array_->dirty(index, 1);
+  }
+
+  void InstancedGeometry::drawPrimitives() {
+    auto instances = (GLsizei)numInstances();
+    if (!instances) {
+      return;
+    }
+
+    bool rebind_elements = false;
+    for (auto& object : draw_objects_) {
+      if (object == element_buffer_) {
+        element_buffer_->drawInstanced(instances);
+      } else if (auto elements = std::dynamic_pointer_cast<GLElementBufferObject>(object)) {
+        elements->sync();
+        elements->drawInstanced(instances);
+        rebind_elements = true;
+      } else if (auto arrays = std::dynamic_pointer_cast<GLElementArrayObject>(object)) {
+        arrays->drawInstanced(instances);
+      }
+    }
+
+    if (rebind_elements && element_buffer_) {
+      element_buffer_->sync();
+    }
+  }
+
+  void InstancedGeometry::computeBounding() {
+    if (!dirty_bounding_ && bounding_sphere_.valid()) {
+      return;
+    }
+
+    dirty_bounding_ = false;
+    bounding_sphere_.init();
+
+    BoundingBox box = localBox();
+    if (!box.valid()) {
+      return;
+    }
+
+    for (auto& transform : *transform_array_) {
+      auto matrix = mv_ * transform;
+      for (unsigned int i = 0; i < 8; ++i) {
+        glm::vec4 corner = matrix * glm::vec4(box.corner(i), 1.f);
+        bounding_sphere_.expandBy(glm::vec3(corner / corner.w));
+      }
+    }
+  }
+}
@@ -0,0 +1,269 @@
+#include <vcg/complex/complex.h>
+#include <vcg/complex/algorithms/clean.h>
+#include <vcg/complex/algorithms/local_optimization.h>
+#include <vcg/complex/algorithms/local_optimization/tri_edge_collapse_quadric.h>
+
+#include <lod_generator.h>
+#include <ambient_occlusion_baker.h>
+
+namespace {
+  class LodVertex;
+  class LodFace;
+  struct LodUsedTypes : public vcg::UsedTypes<vcg::Use<LodVertex>::AsVertexType, vcg::Use<LodFace>::AsFaceType> {};
+
+  class LodVertex : public vcg::Vertex<LodUsedTypes, vcg::vertex::VFAdj, vcg::vertex::Coord3f, vcg::vertex::Normal3f,
+                                       vcg::vertex::Color4b, vcg::vertex::Mark, vcg::vertex::BitFlags> {
+  public:
+    vcg::math::Quadric<double>& Qd() { return quadric_; }
+
+  private:
+    vcg::math::Quadric<double> quadric_;
+  };
+
+  class LodFace : public vcg::Face<LodUsedTypes, vcg::face::VFAdj, vcg::face::VertexRef, vcg::face::BitFlags> {};
+
+  class LodMesh : public vcg::tri::TriMesh<std::vector<LodVertex>, std::vector<LodFace>> {};
+
+  using LodVertexPair = vcg::tri::BasicVertexPair<LodVertex>;
+
+  class LodEdgeCollapse : public vcg::tri::TriEdgeCollapseQuadric<LodMesh, LodVertexPair, LodEdgeCollapse> {
+  public:
+    using Base = vcg::tri::TriEdgeCollapseQuadric<LodMesh, LodVertexPair, LodEdgeCollapse>;
+
+    inline LodEdgeCollapse(const LodVertexPair& pair, int mark, vcg::BaseParameterClass* parameter) :
+      Base(pair, mark, parameter) {
+    }
+  };
+
+  // 每次DoOptimization的时间上限, 便于及时响应退出
+  const float TIME_BUDGET = 0.1f;
+}
+
+namespace Dental {
+  LodGenerator::LodGenerator() :
+    stop_(false),
+    thread_(&LodGenerator::run, this) {
+  }
+
+  LodGenerator::~LodGenerator() {
+    stop_ = true;
+    condition_.notify_all();
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+  LodGenerator& LodGenerator::instance() {
+    static LodGenerator generator;
+    return generator;
+  }
+
+  bool LodGenerator::request(const GeometryPtr& geometry) {
+    // 纹理坐标和标量无法随简化插值; 遮蔽由AmbientOcclusionBaker为每层重新烘焙
+    if (!geometry || !geometry->restore() || !geometry->texcoordArray()->empty() ||
+        geometry->scalarArray()) {
+      return false;
+    }
+
+    auto elements = std::dynamic_pointer_cast<DrawElementsUInt>(geometry->primitiveSet(0));
+    if (!elements || elements->mode() != PrimitiveSet::Mode::TRIANGLES ||
+        elements->size() / 3 < MIN_TRIANGLES * 4) {
+      return false;
+    }
+
+    Job job;
+    job.geometry = geometry;
+    job.revision = geometry->revision();
+    job.triangles = (unsigned int)(elements->size() / 3);
+    job.source.vertices.assign(geometry->vertexArray()->begin(), geometry->vertexArray()->end());
+    if (geometry->colorArray()->size() == geometry->vertexArray()->size()) {
+      job.source.colors.assign(geometry->colorArray()->begin(), geometry->colorArray()->end());
+    }
+    job.source.indices.assign(elements->begin(), elements->begin() + elements->size() / 3 * 3);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_.emplace_back(std::move(job));
+    }
+    condition_.notify_one();
+    return true;
+  }
+
+  bool LodGenerator::ready() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !finished_.empty();
+  }
+
+  unsigned int LodGenerator::frame() {
+    std::vector<Job> finished;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      finished.swap(finished_);
+    }
+
+    unsigned int count = 0;
+    for (auto& job : finished) {
+      auto geometry = job.geometry.lock();
+      if (!geometry || geometry->revision() != job.revision || job.levels.empty()) {
+        continue;
+      }
+
+      std::vector<GeometryPtr> lods;
+      for (auto& level : job.levels) {
+        auto lod = std::make_shared<Geometry>();
+        lod->name(geometry->name());
+        lod->vertexArray()->assign(level.vertices.begin(), level.vertices.end());
+        lod->colorArray()->assign(level.colors.begin(), level.colors.end());
+
+        // 简化后的法向按面积加权的面法向重新计算
+        auto& normals = *lod->normalArray();
+        normals.assign(level.vertices.size(), glm::vec3(0.f));
+        for (std::size_t i = 0; i + 2 < level.indices.size(); i += 3) {
+          auto& a = level.vertices[level.indices[i]];
+          auto& b = level.vertices[level.indices[i + 1]];
+          auto& c = level.vertices[level.indices[i + 2]];
+          auto normal = glm::cross(b - a, c - a);
+          normals[level.indices[i]] += normal;
+          normals[level.indices[i + 1]] += normal;
+          normals[level.indices[i + 2]] += normal;
+        }
+        for (auto& normal : normals) {
+          if (glm::length2(normal) > 0.f) {
+            normal = glm::normalize(normal);
+          }
+        }
+
+        auto elements = std::make_shared<DrawElementsUInt>(PrimitiveSet::Mode::TRIANGLES);
+        elements->assign(level.indices.begin(), level.indices.end());
+        lod->setPrimitiveSet(elements);
+
+        lod->renderTechnique(geometry->renderTechnique());
+        lod->residency(geometry->residency());
+        lods.emplace_back(lod);
+      }
+
+      geometry->lods(lods, job.triangles);
+      if (geometry->occlusionArray()) {
+        for (auto& lod : lods) {
+          AmbientOcclusionBaker::instance().request(lod);
+        }
+      }
+      ++count;
+    }
+
+    return count;
+  }
+
+  void LodGenerator::run() {
+    while (true) {
+      Job job;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [this]() { return stop_ || !pending_.empty(); });
+        if (stop_) {
+          return;
+        }
+
+        job = std::move(pending_.front());
+        pending_.pop_front();
+      }
+
+      // geometry已经析构时不再简化
+      if (job.geometry.expired()) {
+        continue;
+      }
+
+      simplify(job);
+      if (stop_) {
+        return;
+      }
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      finished_.emplace_back(std::move(job));
+    }
+  }
+
+  void LodGenerator::simplify(Job& job) {
+    auto& source = job.source;
+    bool colored = source.colors.size() == source.vertices.size();
+
+    LodMesh mesh;
+    auto vi = vcg::tri::Allocator<LodMesh>::AddVertices(mesh, source.vertices.size());
+    for (std::size_t i = 0; i < source.vertices.size(); ++i, ++vi) {
+      auto& vertex = source.vertices[i];
+      vi->P() = vcg::Point3f(vertex.x, vertex.y, vertex.z);
+      if (colored) {
+        auto color = glm::clamp(source.colors[i], 0.f, 1.f) * 255.f;
+        vi->C() = vcg::Color4b((unsigned char)color.r, (unsigned char)color.g, (unsigned char)color.b, (unsigned char)color.a);
+      }
+    }
+
+    auto fi = vcg::tri::Allocator<LodMesh>::AddFaces(mesh, source.indices.size() / 3);
+    for (std::size_t i = 0; i + 2 < source.indices.size(); i += 3, ++fi) {
+      for (int j = 0; j < 3; ++j) {
+        fi->V(j) = &mesh.vert[source.indices[i + j]];
+      }
+    }
+
+    auto target = (int)(source.indices.size() / 3);
+    source = Level();
+
+    // STL读入的三角形不共享顶点, 需要先合并才能折叠
+    vcg::tri::Clean<LodMesh>::RemoveDuplicateVertex(mesh);
+    vcg::tri::Clean<LodMesh>::RemoveUnreferencedVertex(mesh);
+    vcg::tri::Allocator<LodMesh>::CompactEveryVector(mesh);
+    vcg::tri::UpdateBounding<LodMesh>::Box(mesh);
+
+    vcg::tri::TriEdgeCollapseQuadricParameter parameter;
+    parameter.QualityThr = 0.3;
+    parameter.PreserveBoundary = true;
+    parameter.NormalCheck = true;
+
+    vcg::LocalOptimization<LodMesh> session(mesh, &parameter);
+    session.Init<LodEdgeCollapse>();
+    session.SetTimeBudget(TIME_BUDGET);
+
+    for (unsigned int level = 0; level < MAX_LEVELS; ++level) {
+      target /= 4;
+      if (target < (int)MIN_TRIANGLES) {
+        break;
+      }
+
+      session.SetTargetSimplices(target);
+      while (!stop_ && mesh.fn > target && session.DoOptimization()) {
+      }
+
+      if (stop_ || mesh.fn > target * 2) {
+        break;
+      }
+
+      Level result;
+      std::vector<unsigned int> remap(mesh.vert.size(), 0);
+      for (std::size_t i = 0; i < mesh.vert.size(); ++i) {
+        auto& vertex = mesh.vert[i];
+        if (vertex.IsD()) {
+          continue;
+        }
+
+        remap[i] = (unsigned int)result.vertices.size();
+        result.vertices.emplace_back(vertex.P()[0], vertex.P()[1], vertex.P()[2]);
+        if (colored) {
+          result.colors.emplace_back(vertex.C()[0] / 255.f, vertex.C()[1] / 255.f, vertex.C()[2] / 255.f, vertex.C()[3] / 255.f);
+        }
+      }
+
+      for (auto& face : mesh.face) {
+        if (face.IsD()) {
+          continue;
+        }
+        for (int j = 0; j < 3; ++j) {
+          result.indices.emplace_back(remap[vcg::tri::Index(mesh, face.V(j))]);
+        }
+      }
+
+      job.levels.emplace_back(std::move(result));
+    }
+
+    session.Finalize<LodEdgeCollapse>();
+  }
+}
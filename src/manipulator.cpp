@@ -342,6 +342,10 @@ namespace Dental {
     return handled;
   }
 
+  bool Manipulator::moving() {
+    return pointer_pressed_ || flightParams_.valid();
+  }
+
   bool Manipulator::mousePress(Event &event) {
     last_point0_ = event.firstProjectPoint();
     pointer_pressed_ = true;
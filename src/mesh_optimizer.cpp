@@ -0,0 +1,853 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <thread>
+#include <mesh_optimizer.h>
+#include <timer.h>
+
+namespace {
+  class Adjacency {
+  public:
+    Adjacency(const std::vector<unsigned int>& indices, unsigned int vertex_count) :
+      offsets_(vertex_count + 1, 0),
+      triangles_(indices.size() / 3 * 3) {
+      for (unsigned int i = 0; i < triangles_.size(); ++i) {
+        ++offsets_[indices[i] + 1];
+      }
+
+      for (unsigned int i = 0; i < vertex_count; ++i) {
+        offsets_[i + 1] += offsets_[i];
+      }
+
+      std::vector<unsigned int> cursor(offsets_.begin(), offsets_.end() - 1);
+      for (unsigned int i = 0; i < triangles_.size(); ++i) {
+        triangles_[cursor[indices[i]]++] = i / 3;
+      }
+    }
+
+    inline unsigned int count(unsigned int vertex) const {
+      return offsets_[vertex + 1] - offsets_[vertex];
+    }
+
+    inline const unsigned int* begin(unsigned int vertex) const {
+      return triangles_.data() + offsets_[vertex];
+    }
+
+    inline const unsigned int* end(unsigned int vertex) const {
+      return triangles_.data() + offsets_[vertex + 1];
+    }
+
+  private:
+    std::vector<unsigned int> offsets_;
+    std::vector<unsigned int> triangles_;
+  };
+
+  int skipDeadEnd(const std::vector<unsigned int>& live, std::vector<unsigned int>& dead_end,
+                  unsigned int& cursor, unsigned int vertex_count) {
+    while (!dead_end.empty()) {
+      unsigned int vertex = dead_end.back();
+      dead_end.pop_back();
+      if (live[vertex] > 0) {
+        return (int)vertex;
+      }
+    }
+
+    while (cursor < vertex_count) {
+      if (live[cursor] > 0) {
+        return (int)cursor;
+      }
+      ++cursor;
+    }
+
+    return -1;
+  }
+
+  int nextVertex(const std::vector<unsigned int>& candidates, const std::vector<unsigned int>& live,
+                 const std::vector<unsigned int>& cache_time, unsigned int time_stamp, unsigned int cache_size,
+                 std::vector<unsigned int>& dead_end, unsigned int& cursor, unsigned int vertex_count) {
+    int best = -1;
+    unsigned int best_priority = 0;
+
+    for (auto vertex : candidates) {
+      if (live[vertex] == 0) {
+        continue;
+      }
+
+      // 三角形扇展开后vertex仍在缓存中, 优先选择在缓存中最久的
+      unsigned int priority = 0;
+      if (time_stamp - cache_time[vertex] + 2 * live[vertex] <= cache_size) {
+        priority = time_stamp - cache_time[vertex];
+      }
+
+      if (priority > best_priority) {
+        best_priority = priority;
+        best = (int)vertex;
+      }
+    }
+
+    if (best == -1) {
+      best = skipDeadEnd(live, dead_end, cursor, vertex_count);
+    }
+    return best;
+  }
+
+  template<typename ARRAY>
+  void remapArray(ARRAY& array, const std::vector<unsigned int>& remap) {
+    if (array.size() != remap.size()) {
+      return;
+    }
+
+    std::vector<typename ARRAY::value_type> copy(array.begin(), array.end());
+    for (unsigned int i = 0; i < remap.size(); ++i) {
+      array[remap[i]] = copy[i];
+    }
+    array.dirty();
+  }
+
+  template<typename ARRAY>
+  unsigned int streamSize(const ARRAY& array, unsigned int vertex_count) {
+    return array.size() == vertex_count ? (unsigned int)sizeof(typename ARRAY::value_type) : 0;
+  }
+
+  std::vector<unsigned int> collectIndices(const Dental::Geometry& geometry) {
+    std::vector<unsigned int> indices;
+    for (unsigned int i = 0; i < geometry.numPrimitiveSets(); ++i) {
+      auto elements = std::dynamic_pointer_cast<Dental::DrawElementsUInt>(geometry.primitiveSet(i));
+      if (elements) {
+        indices.insert(indices.end(), elements->begin(), elements->end());
+      }
+    }
+    return indices;
+  }
+
+  float computeGeometryOverfetch(const Dental::Geometry& geometry) {
+    auto indices = collectIndices(geometry);
+    unsigned int vertex_count = (unsigned int)geometry.vertexArray()->size();
+
+    // 每个属性是独立的buffer, 分别统计后按字节数加权
+    auto scalars = geometry.scalarArray();
+    unsigned int sizes[] = {
+      streamSize(*geometry.vertexArray(), vertex_count),
+      streamSize(*geometry.normalArray(), vertex_count),
+      streamSize(*geometry.colorArray(), vertex_count),
+      streamSize(*geometry.texcoordArray(), vertex_count),
+      scalars ? streamSize(*scalars, vertex_count) : 0
+    };
+
+    float fetched = 0.f;
+    unsigned int total = 0;
+    for (auto size : sizes) {
+      if (size) {
+        fetched += Dental::MeshOptimizer::computeOverfetch(indices, vertex_count, size) * size;
+        total += size;
+      }
+    }
+    return total ? fetched / total : 0.f;
+  }
+
+  bool isTriangles(const Dental::PrimitiveSetPtr& primitive_set) {
+    return primitive_set &&
+      primitive_set->type() == Dental::PrimitiveSet::Type::DRAW_ELEMENTS_UINT &&
+      primitive_set->mode() == Dental::PrimitiveSet::Mode::TRIANGLES;
+  }
+
+  // 沿三角形重心包围盒的最长轴按中位数递归二分, 每段不超过max_triangles个三角形
+  void splitClusters(const std::vector<glm::vec3>& centroids, std::vector<unsigned int>& order,
+                     unsigned int begin, unsigned int end, unsigned int max_triangles,
+                     std::vector<std::pair<unsigned int, unsigned int>>& ranges) {
+    if (end - begin <= max_triangles) {
+      ranges.emplace_back(begin, end);
+      return;
+    }
+
+    Dental::BoundingBox box;
+    for (unsigned int i = begin; i < end; ++i) {
+      box.expandBy(centroids[order[i]]);
+    }
+
+    auto extent = box.max() - box.min();
+    int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+    // 稳定划分, 保留簇内原有的三角形顺序(如顶点缓存优化的结果)
+    std::vector<float> keys;
+    keys.reserve(end - begin);
+    for (unsigned int i = begin; i < end; ++i) {
+      keys.emplace_back(centroids[order[i]][axis]);
+    }
+    std::nth_element(keys.begin(), keys.begin() + keys.size() / 2, keys.end());
+    float median = keys[keys.size() / 2];
+
+    auto middle = (unsigned int)(std::stable_partition(order.begin() + begin, order.begin() + end,
+      [&](unsigned int triangle) { return centroids[triangle][axis] < median; }) - order.begin());
+
+    // 大量重心重合时中位数划分不开, 按位置对半分
+    if (middle == begin || middle == end) {
+      middle = begin + (end - begin) / 2;
+    }
+
+    splitClusters(centroids, order, begin, middle, max_triangles, ranges);
+    splitClusters(centroids, order, middle, end, max_triangles, ranges);
+  }
+
+  // 提取边时每个线程至少处理的三角形数, 小模型不值得开线程
+  const unsigned int MIN_EDGE_TRIANGLES_PER_THREAD = 65536;
+  const unsigned int MAX_EDGE_THREADS = 8;
+  const unsigned int INVALID_INDEX = 0xffffffffu;
+
+  unsigned int edgeThreads(unsigned int triangle_count) {
+    auto threads = std::min(std::max(1u, std::thread::hardware_concurrency()), MAX_EDGE_THREADS);
+    return std::max(1u, std::min(threads, triangle_count / MIN_EDGE_TRIANGLES_PER_THREAD));
+  }
+
+  // 在threads个线程上执行function(thread), 第0份在调用线程上执行
+  template<typename FUNCTION>
+  void parallel(unsigned int threads, const FUNCTION& function) {
+    std::vector<std::thread> workers;
+    for (unsigned int i = 1; i < threads; ++i) {
+      workers.emplace_back(function, i);
+    }
+    function(0);
+    for (auto& worker : workers) {
+      worker.join();
+    }
+  }
+
+  // [0, count)平均分成parts段中的第part段的起点
+  inline unsigned int split(unsigned int count, unsigned int part, unsigned int parts) {
+    return (unsigned int)((unsigned long long)count * part / parts);
+  }
+
+  inline unsigned int positionHash(const glm::vec3& position) {
+    // 加0把-0变为+0, 与浮点数的==一致
+    float values[3] = { position.x + 0.f, position.y + 0.f, position.z + 0.f };
+    unsigned int bits[3];
+    std::memcpy(bits, values, sizeof(bits));
+
+    // 整数坐标的浮点数低位全为0, 乘法只向高位传播, 取64位乘积的高32位才能用上所有位
+    auto hash = (unsigned long long)bits[0];
+    hash = hash * 0x9e3779b97f4a7c15ull ^ bits[1];
+    hash = hash * 0x9e3779b97f4a7c15ull ^ bits[2];
+    hash *= 0x9e3779b97f4a7c15ull;
+    return (unsigned int)(hash >> 32);
+  }
+
+  struct WeldedVertices {
+    // 每个顶点合并后的连续编号
+    std::vector<unsigned int> remap;
+    // 每个合并编号对应的最小原编号
+    std::vector<unsigned int> representatives;
+  };
+
+  // 合并位置相同的顶点; 按哈希的高位分给各线程, 每个线程只写自己的开放寻址表
+  WeldedVertices weldVertices(const std::vector<glm::vec3>& vertices, unsigned int threads) {
+    auto vertex_count = (unsigned int)vertices.size();
+
+    // 先记录每个顶点所在位置的最小原编号, 再按编号顺序压缩为连续编号
+    std::vector<unsigned int> canonical(vertex_count);
+    parallel(threads, [&](unsigned int thread) {
+      // 槽中同时存哈希, 哈希不同时不必读取顶点; 相同位置的第一个顶点通常就在附近, 读取多半命中缓存
+      struct Slot {
+        unsigned int hash;
+        unsigned int index;
+      };
+
+      // STL的顶点约为不同位置的6倍, 表从较小的容量开始, 超过3/4时扩容
+      unsigned int capacity = 1024;
+      while (capacity < vertex_count / threads / 4) {
+        capacity <<= 1;
+      }
+      std::vector<Slot> table(capacity, Slot{ 0, INVALID_INDEX });
+      unsigned int size = 0;
+
+      // 按编号顺序插入, 先插入的即最小编号
+      for (unsigned int i = 0; i < vertex_count; ++i) {
+        auto hash = positionHash(vertices[i]);
+        if ((unsigned int)(((unsigned long long)hash * threads) >> 32) != thread) {
+          continue;
+        }
+
+        auto mask = capacity - 1;
+        for (auto slot = hash & mask; ; slot = (slot + 1) & mask) {
+          auto& entry = table[slot];
+          if (entry.index == INVALID_INDEX) {
+            entry = { hash, i };
+            canonical[i] = i;
+            ++size;
+            break;
+          }
+          if (entry.hash == hash && vertices[entry.index] == vertices[i]) {
+            canonical[i] = entry.index;
+            break;
+          }
+        }
+
+        if (size * 4 > capacity * 3) {
+          capacity <<= 1;
+          std::vector<Slot> larger(capacity, Slot{ 0, INVALID_INDEX });
+          for (auto& entry : table) {
+            if (entry.index == INVALID_INDEX) {
+              continue;
+            }
+
+            auto slot = entry.hash & (capacity - 1);
+            while (larger[slot].index != INVALID_INDEX) {
+              slot = (slot + 1) & (capacity - 1);
+            }
+            larger[slot] = entry;
+          }
+          table.swap(larger);
+        }
+      }
+    });
+
+    // 最小原编号一定先出现, 顺序扫描即可压缩
+    WeldedVertices welded;
+    welded.remap.swap(canonical);
+    for (unsigned int i = 0; i < vertex_count; ++i) {
+      auto& index = welded.remap[i];
+      if (index == i) {
+        index = (unsigned int)welded.representatives.size();
+        welded.representatives.emplace_back(i);
+      } else {
+        index = welded.remap[index];
+      }
+    }
+    return welded;
+  }
+
+}
+
+namespace Dental::MeshOptimizer {
+  float computeACMR(const std::vector<unsigned int>& indices, unsigned int cache_size) {
+    unsigned int triangle_count = (unsigned int)(indices.size() / 3);
+    if (!triangle_count || !cache_size) {
+      return 0.f;
+    }
+
+    unsigned int vertex_count = *std::max_element(indices.begin(), indices.end()) + 1;
+
+    // cache_time[v]记录v进入FIFO时的序号, 序号差超过cache_size即已被挤出
+    std::vector<unsigned int> cache_time(vertex_count, 0);
+    unsigned int time_stamp = cache_size + 1;
+    unsigned int misses = 0;
+
+    for (unsigned int i = 0; i < triangle_count * 3; ++i) {
+      unsigned int vertex = indices[i];
+      if (time_stamp - cache_time[vertex] > cache_size) {
+        cache_time[vertex] = time_stamp++;
+        ++misses;
+      }
+    }
+
+    return (float)misses / triangle_count;
+  }
+
+  void optimizeVertexCache(std::vector<unsigned int>& indices, unsigned int vertex_count, unsigned int cache_size) {
+    unsigned int triangle_count = (unsigned int)(indices.size() / 3);
+    if (!triangle_count) {
+      return;
+    }
+
+    vertex_count = std::max(vertex_count, *std::max_element(indices.begin(), indices.end()) + 1);
+
+    Adjacency adjacency(indices, vertex_count);
+
+    std::vector<unsigned int> live(vertex_count);
+    for (unsigned int i = 0; i < vertex_count; ++i) {
+      live[i] = adjacency.count(i);
+    }
+
+    std::vector<unsigned int> cache_time(vertex_count, 0);
+    std::vector<bool> emitted(triangle_count, false);
+    std::vector<unsigned int> dead_end;
+    std::vector<unsigned int> candidates;
+    dead_end.reserve(indices.size());
+    candidates.reserve(cache_size * 3);
+
+    std::vector<unsigned int> output;
+    output.reserve(triangle_count * 3);
+
+    unsigned int time_stamp = cache_size + 1;
+    unsigned int cursor = 0;
+    int fanning = skipDeadEnd(live, dead_end, cursor, vertex_count);
+
+    while (fanning >= 0) {
+      candidates.clear();
+
+      for (auto t = adjacency.begin(fanning); t != adjacency.end(fanning); ++t) {
+        unsigned int triangle = *t;
+        if (emitted[triangle]) {
+          continue;
+        }
+
+        for (unsigned int k = 0; k < 3; ++k) {
+          unsigned int vertex = indices[triangle * 3 + k];
+          output.emplace_back(vertex);
+          dead_end.emplace_back(vertex);
+          candidates.emplace_back(vertex);
+          --live[vertex];
+
+          if (time_stamp - cache_time[vertex] > cache_size) {
+            cache_time[vertex] = time_stamp++;
+          }
+        }
+        emitted[triangle] = true;
+      }
+
+      fanning = nextVertex(candidates, live, cache_time, time_stamp, cache_size, dead_end, cursor, vertex_count);
+    }
+
+    // 多余的不完整三角形索引原样保留
+    output.insert(output.end(), indices.begin() + triangle_count * 3, indices.end());
+    indices.swap(output);
+  }
+
+  CacheStatistics optimizeVertexCache(Geometry& geometry, unsigned int cache_size) {
+    geometry.restore();
+    CacheStatistics statistics{ 0.f, 0.f };
+
+    unsigned int vertex_count = (unsigned int)geometry.vertexArray()->size();
+    unsigned int triangle_count = 0;
+
+    for (unsigned int i = 0; i < geometry.numPrimitiveSets(); ++i) {
+      auto primitive_set = geometry.primitiveSet(i);
+      if (!isTriangles(primitive_set)) {
+        continue;
+      }
+
+      auto elements = std::dynamic_pointer_cast<DrawElementsUInt>(primitive_set);
+      if (!elements || elements->size() < 3) {
+        continue;
+      }
+
+      unsigned int count = elements->numPrimitives();
+      statistics.acmr_before += computeACMR(*elements, cache_size) * count;
+
+      optimizeVertexCache(*elements, vertex_count, cache_size);
+      elements->dirty();
+
+      statistics.acmr_after += computeACMR(*elements, cache_size) * count;
+      triangle_count += count;
+
+      // 三角形顺序改变后原有的分簇失效
+      if (i == 0) {
+        geometry.clusters({});
+      }
+    }
+
+    if (triangle_count) {
+      statistics.acmr_before /= triangle_count;
+      statistics.acmr_after /= triangle_count;
+    }
+
+    return statistics;
+  }
+
+  float computeOverfetch(const std::vector<unsigned int>& indices, unsigned int vertex_count, unsigned int vertex_size) {
+    static const unsigned int cache_line = 64;
+    static const unsigned int cache_lines = 256;
+    static const unsigned int vertex_cache_size = 16;
+
+    if (indices.empty() || !vertex_count || !vertex_size) {
+      return 0.f;
+    }
+
+    vertex_count = std::max(vertex_count, *std::max_element(indices.begin(), indices.end()) + 1);
+
+    std::vector<unsigned int> vertex_time(vertex_count, 0);
+    std::vector<bool> referenced(vertex_count, false);
+    unsigned int vertex_stamp = vertex_cache_size + 1;
+
+    unsigned int line_count = (unsigned int)(((size_t)vertex_count * vertex_size + cache_line - 1) / cache_line);
+    std::vector<unsigned int> line_time(line_count, 0);
+    unsigned int line_stamp = cache_lines + 1;
+
+    size_t fetched = 0;
+    size_t unique = 0;
+
+    for (auto vertex : indices) {
+      if (!referenced[vertex]) {
+        referenced[vertex] = true;
+        unique += vertex_size;
+      }
+
+      if (vertex_stamp - vertex_time[vertex] <= vertex_cache_size) {
+        continue;
+      }
+      vertex_time[vertex] = vertex_stamp++;
+
+      size_t start = (size_t)vertex * vertex_size;
+      unsigned int first = (unsigned int)(start / cache_line);
+      unsigned int last = (unsigned int)((start + vertex_size - 1) / cache_line);
+      for (unsigned int line = first; line <= last; ++line) {
+        if (line_stamp - line_time[line] > cache_lines) {
+          line_time[line] = line_stamp++;
+          fetched += cache_line;
+        }
+      }
+    }
+
+    return unique ? (float)fetched / unique : 0.f;
+  }
+
+  std::vector<unsigned int> optimizeVertexFetchRemap(const std::vector<unsigned int>& indices, unsigned int vertex_count) {
+    static const unsigned int unused = ~0u;
+
+    std::vector<unsigned int> remap(vertex_count, unused);
+    unsigned int next = 0;
+
+    for (auto index : indices) {
+      if (index < vertex_count && remap[index] == unused) {
+        remap[index] = next++;
+      }
+    }
+
+    // 未被引用的顶点保持相对顺序放到末尾
+    for (auto& index : remap) {
+      if (index == unused) {
+        index = next++;
+      }
+    }
+
+    return remap;
+  }
+
+  FetchStatistics optimizeVertexFetch(Geometry& geometry) {
+    geometry.restore();
+    FetchStatistics statistics{ 0.f, 0.f };
+
+    unsigned int vertex_count = (unsigned int)geometry.vertexArray()->size();
+    auto indices = collectIndices(geometry);
+    if (!vertex_count || indices.empty()) {
+      return statistics;
+    }
+
+    statistics.overfetch_before = computeGeometryOverfetch(geometry);
+
+    auto remap = optimizeVertexFetchRemap(indices, vertex_count);
+
+    remapArray(*geometry.vertexArray(), remap);
+    remapArray(*geometry.normalArray(), remap);
+    remapArray(*geometry.colorArray(), remap);
+    remapArray(*geometry.texcoordArray(), remap);
+    if (auto scalars = geometry.scalarArray()) {
+      remapArray(*scalars, remap);
+    }
+
+    for (unsigned int i = 0; i < geometry.numPrimitiveSets(); ++i) {
+      auto elements = std::dynamic_pointer_cast<DrawElementsUInt>(geometry.primitiveSet(i));
+      if (!elements) {
+        continue;
+      }
+
+      for (auto& index : *elements) {
+        if (index < vertex_count) {
+          index = remap[index];
+        }
+      }
+      elements->dirty();
+    }
+
+    geometry.dirty();
+
+    statistics.overfetch_after = computeGeometryOverfetch(geometry);
+    return statistics;
+  }
+
+  unsigned int buildClusters(Geometry& geometry, unsigned int max_triangles) {
+    geometry.restore();
+    geometry.clusters({});
+
+    auto primitive_set = geometry.primitiveSet(0);
+    auto elements = std::dynamic_pointer_cast<DrawElementsUInt>(primitive_set);
+    const auto& vertices = *geometry.vertexArray();
+    if (!isTriangles(primitive_set) || !elements || !max_triangles) {
+      return 0;
+    }
+
+    auto triangle_count = (unsigned int)(elements->size() / 3);
+    if (triangle_count <= max_triangles) {
+      return 0;
+    }
+
+    auto& indices = *elements;
+    for (unsigned int i = 0; i < triangle_count * 3; ++i) {
+      if (indices[i] >= vertices.size()) {
+        return 0;
+      }
+    }
+
+    std::vector<glm::vec3> centroids(triangle_count);
+    for (unsigned int i = 0; i < triangle_count; ++i) {
+      centroids[i] = (vertices[indices[i * 3]] + vertices[indices[i * 3 + 1]] + vertices[indices[i * 3 + 2]]) / 3.f;
+    }
+
+    std::vector<unsigned int> order(triangle_count);
+    std::iota(order.begin(), order.end(), 0);
+
+    std::vector<std::pair<unsigned int, unsigned int>> ranges;
+    splitClusters(centroids, order, 0, triangle_count, max_triangles, ranges);
+
+    // 按簇重排三角形, 每个簇是一段连续的索引; 多余的不完整三角形索引原样保留
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+    for (auto triangle : order) {
+      output.insert(output.end(), indices.begin() + triangle * 3, indices.begin() + triangle * 3 + 3);
+    }
+    output.insert(output.end(), indices.begin() + triangle_count * 3, indices.end());
+    indices.swap(output);
+
+    Clusters clusters;
+    clusters.reserve(ranges.size());
+    for (auto& range : ranges) {
+      Cluster cluster{ range.first * 3, (range.second - range.first) * 3, BoundingSphere(), glm::vec3(0.f), 2.f };
+
+      BoundingBox box;
+      std::vector<glm::vec3> normals;
+      normals.reserve(range.second - range.first);
+      for (unsigned int i = cluster.first; i < cluster.first + cluster.count; i += 3) {
+        const auto& a = vertices[indices[i]];
+        const auto& b = vertices[indices[i + 1]];
+        const auto& c = vertices[indices[i + 2]];
+        box.expandBy(a);
+        box.expandBy(b);
+        box.expandBy(c);
+
+        // 叉积的长度为面积的两倍, 按面积加权得到锥轴
+        auto normal = glm::cross(b - a, c - a);
+        cluster.axis += normal;
+        if (glm::length2(normal) > 0.f) {
+          normals.emplace_back(glm::normalize(normal));
+        }
+      }
+      cluster.sphere.set(box.center(), box.radius());
+
+      if (glm::length2(cluster.axis) > 0.f && !normals.empty()) {
+        cluster.axis = glm::normalize(cluster.axis);
+
+        float min_dot = 1.f;
+        for (auto& normal : normals) {
+          min_dot = std::min(min_dot, glm::dot(normal, cluster.axis));
+        }
+
+        // 锥角不小于90度时总有朝向视点的三角形, 不做背面裁剪
+        if (min_dot > 0.f) {
+          cluster.cutoff = std::sqrt(1.f - min_dot * min_dot);
+        }
+      }
+
+      clusters.emplace_back(cluster);
+    }
+
+    elements->dirty();
+    geometry.dirty();
+    geometry.clusters(clusters);
+
+    return (unsigned int)clusters.size();
+  }
+
+  Edges extractEdges(const std::vector<unsigned int>& indices, const std::vector<glm::vec3>& vertices,
+                     float crease_angle) {
+    Edges edges;
+    edges.non_manifold = 0;
+
+    auto vertex_count = (unsigned int)vertices.size();
+    auto triangle_count = (unsigned int)(indices.size() / 3);
+    if (!vertex_count || !triangle_count) {
+      return edges;
+    }
+
+    auto threads = edgeThreads(triangle_count);
+    auto welded = weldVertices(vertices, threads);
+    auto& remap = welded.remap;
+    auto& representatives = welded.representatives;
+    auto welded_count = (unsigned int)representatives.size();
+
+    // 先按三角形分段并行计算合并后的角点和面法向, 含越界索引的三角形角点记为INVALID_INDEX
+    std::vector<unsigned int> corners(triangle_count * 3);
+    std::vector<glm::vec3> normals(triangle_count);
+    parallel(threads, [&](unsigned int thread) {
+      auto end = split(triangle_count, thread + 1, threads);
+      for (auto face = split(triangle_count, thread, threads); face < end; ++face) {
+        auto i0 = indices[face * 3], i1 = indices[face * 3 + 1], i2 = indices[face * 3 + 2];
+        if (i0 >= vertex_count || i1 >= vertex_count || i2 >= vertex_count) {
+          corners[face * 3] = corners[face * 3 + 1] = corners[face * 3 + 2] = INVALID_INDEX;
+          normals[face] = glm::vec3(0.f);
+          continue;
+        }
+
+        corners[face * 3] = remap[i0];
+        corners[face * 3 + 1] = remap[i1];
+        corners[face * 3 + 2] = remap[i2];
+
+        auto normal = glm::cross(vertices[i1] - vertices[i0], vertices[i2] - vertices[i0]);
+        normals[face] = glm::length2(normal) > 0.f ? glm::normalize(normal) : normal;
+      }
+    });
+
+    // 每条无向边归属于合并编号较小的端点; 线程i只处理归属于第i段端点的边,
+    // 各自顺序扫描全部角点, 写入的位置互不重叠, 不需要加锁
+    auto forEachEdge = [&](unsigned int thread, const auto& function) {
+      auto first_vertex = split(welded_count, thread, threads);
+      auto last_vertex = split(welded_count, thread + 1, threads);
+      for (unsigned int face = 0; face < triangle_count; ++face) {
+        auto corner = &corners[face * 3];
+        for (int j = 0; j < 3; ++j) {
+          auto a = std::min(corner[j], corner[(j + 1) % 3]);
+          auto b = std::max(corner[j], corner[(j + 1) % 3]);
+          if (a != b && a >= first_vertex && a < last_vertex) {
+            function(face, a, b);
+          }
+        }
+      }
+    };
+
+    // 统计每个端点的边数
+    std::vector<unsigned int> starts(welded_count + 1, 0);
+    parallel(threads, [&](unsigned int thread) {
+      forEachEdge(thread, [&](unsigned int, unsigned int a, unsigned int) {
+        ++starts[a + 1];
+      });
+    });
+
+    for (unsigned int i = 0; i < welded_count; ++i) {
+      starts[i + 1] += starts[i];
+    }
+
+    // 把边按端点连续存放
+    struct EdgeRecord {
+      unsigned int other;
+      unsigned int face;
+    };
+    std::vector<EdgeRecord> records(starts[welded_count]);
+    parallel(threads, [&](unsigned int thread) {
+      auto first_vertex = split(welded_count, thread, threads);
+      auto last_vertex = split(welded_count, thread + 1, threads);
+      std::vector<unsigned int> cursors(starts.begin() + first_vertex, starts.begin() + last_vertex);
+      forEachEdge(thread, [&](unsigned int face, unsigned int a, unsigned int b) {
+        records[cursors[a - first_vertex]++] = { b, face };
+      });
+    });
+
+    // 同一端点的边再按另一端点分组, 组内的三角形数决定边的类型
+    auto crease_cos = std::cos(glm::radians(crease_angle));
+    std::vector<Edges> results(threads);
+    parallel(threads, [&](unsigned int thread) {
+      auto first_vertex = split(welded_count, thread, threads);
+      auto last_vertex = split(welded_count, thread + 1, threads);
+      auto& result = results[thread];
+      result.non_manifold = 0;
+      result.unique.reserve(starts[last_vertex] - starts[first_vertex]);
+
+      auto less = [](const EdgeRecord& lhs, const EdgeRecord& rhs) { return lhs.other < rhs.other; };
+      for (auto vertex = first_vertex; vertex < last_vertex; ++vertex) {
+        auto first = records.begin() + starts[vertex];
+        auto last = records.begin() + starts[vertex + 1];
+
+        // 通常只有几条边, 插入排序比std::sort快
+        if (last - first > 16) {
+          std::sort(first, last, less);
+        } else {
+          for (auto i = first; i != last; ++i) {
+            for (auto j = i; j != first && less(*j, *(j - 1)); --j) {
+              std::swap(*j, *(j - 1));
+            }
+          }
+        }
+
+        auto a = representatives[vertex];
+        for (auto group = first; group != last; ) {
+          auto next = group + 1;
+          while (next != last && next->other == group->other) {
+            ++next;
+          }
+
+          auto b = representatives[group->other];
+          result.unique.emplace_back(a);
+          result.unique.emplace_back(b);
+
+          if (next - group != 2) {
+            result.boundary.emplace_back(a);
+            result.boundary.emplace_back(b);
+            result.non_manifold += next - group > 2 ? 1 : 0;
+          } else {
+            // 退化三角形没有法向, 不判定为折边
+            auto& n0 = normals[group->face];
+            auto& n1 = normals[(group + 1)->face];
+            if (glm::length2(n0) > 0.f && glm::length2(n1) > 0.f && glm::dot(n0, n1) < crease_cos) {
+              result.crease.emplace_back(a);
+              result.crease.emplace_back(b);
+            }
+          }
+          group = next;
+        }
+      }
+    });
+
+    if (threads == 1) {
+      return std::move(results[0]);
+    }
+
+    std::size_t unique_size = 0, boundary_size = 0, crease_size = 0;
+    for (auto& result : results) {
+      unique_size += result.unique.size();
+      boundary_size += result.boundary.size();
+      crease_size += result.crease.size();
+    }
+    edges.unique.reserve(unique_size);
+    edges.boundary.reserve(boundary_size);
+    edges.crease.reserve(crease_size);
+
+    for (auto& result : results) {
+      edges.unique.insert(edges.unique.end(), result.unique.begin(), result.unique.end());
+      edges.boundary.insert(edges.boundary.end(), result.boundary.begin(), result.boundary.end());
+      edges.crease.insert(edges.crease.end(), result.crease.begin(), result.crease.end());
+      edges.non_manifold += result.non_manifold;
+    }
+    return edges;
+  }
+
+  EdgeStatistics extractEdges(Geometry& geometry, float crease_angle) {
+    Timer timer;
+    geometry.restore();
+
+    auto edges = extractEdges(collectTriangles(geometry), *geometry.vertexArray(), crease_angle);
+
+    EdgeStatistics statistics;
+    statistics.edges = (unsigned int)(edges.unique.size() / 2);
+    statistics.boundary_edges = (unsigned int)(edges.boundary.size() / 2);
+    statistics.crease_edges = (unsigned int)(edges.crease.size() / 2);
+    statistics.non_manifold_edges = edges.non_manifold;
+
+    setOverlays(geometry, edges);
+
+    statistics.milliseconds = (float)timer.time_m();
+    return statistics;
+  }
+
+  std::vector<unsigned int> collectTriangles(const Geometry& geometry) {
+    std::vector<unsigned int> indices;
+    for (unsigned int i = 0; i < geometry.numPrimitiveSets(); ++i) {
+      auto primitive_set = geometry.primitiveSet(i);
+      if (isTriangles(primitive_set)) {
+        auto elements = std::dynamic_pointer_cast<DrawElementsUInt>(primitive_set);
+        indices.insert(indices.end(), elements->begin(), elements->begin() + elements->size() / 3 * 3);
+      }
+    }
+    return indices;
+  }
+
+  void setOverlays(Geometry& geometry, Edges& edges) {
+    auto lines = [](std::vector<unsigned int>& indices) {
+      auto elements = std::make_shared<DrawElementsUInt>(PrimitiveSet::Mode::LINES);
+      elements->swap(indices);
+      return elements;
+    };
+
+    // 空的图元表示已经提取过, 避免每帧重新提取
+    geometry.overlay(Geometry::Overlay::EDGES, lines(edges.unique));
+    geometry.overlay(Geometry::Overlay::BOUNDARY_EDGES, lines(edges.boundary));
+    geometry.overlay(Geometry::Overlay::CREASE_EDGES, lines(edges.crease));
+  }
+}
@@ -95,6 +95,7 @@ namespace Dental {
     if (itr == geometrys_.end()) {
       geometry->parent(ptr());
       geometrys_.emplace_back(geometry);
+      dirtyBounding();
     }
   }
 
@@ -113,6 +114,7 @@ namespace Dental {
       if (itr != geometrys_.end()) {
         geometry->parent(ptr());
         geometrys_.emplace(itr, geometry);
+        dirtyBounding();
       }
     }
   }
@@ -144,6 +146,7 @@ namespace Dental {
     }
     geometrys_[index]->parent(NodePtr());
     geometrys_.erase(geometrys_.begin() + index);
+    dirtyBounding();
     return true;
   }
 
@@ -152,6 +155,7 @@ namespace Dental {
     if (itr != geometrys_.end()) {
       geometry->parent(NodePtr());
       geometrys_.erase(itr);
+      dirtyBounding();
       return true;
     }
     return false;
@@ -162,6 +166,7 @@ namespace Dental {
       geometry->parent(NodePtr());
     }
     decltype(geometrys_)().swap(geometrys_);
+    dirtyBounding();
   }
 
   BoundingSphere &Node::boundingSphere() {
@@ -0,0 +1,400 @@
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <map>
+#include <unordered_map>
+#include <occlusion_culler.h>
+
+namespace {
+  // 包围球在NDC中的半径小于该值的geometry不作为遮挡体
+  const float MIN_OCCLUDER_SIZE = 0.2f;
+
+  // 深度比较的容差, 避免平面的包围盒被自身挡住
+  const float DEPTH_BIAS = 1e-4f;
+
+  const unsigned int NO_NEIGHBOR = ~0u;
+
+  bool sameViewport(const Dental::Viewport& lhs, const Dental::Viewport& rhs) {
+    return lhs.x() == rhs.x() && lhs.y() == rhs.y() && lhs.width() == rhs.width() && lhs.height() == rhs.height();
+  }
+
+  unsigned int numTriangles(const Dental::Geometry& geometry) {
+    unsigned int triangles = 0;
+    for (unsigned int i = 0; i < geometry.numPrimitiveSets(); ++i) {
+      auto primitive_set = geometry.primitiveSet(i);
+      if (primitive_set->mode() == Dental::PrimitiveSet::Mode::TRIANGLES) {
+        triangles += primitive_set->numIndices() / 3;
+      }
+    }
+    return triangles;
+  }
+
+  void collectTriangles(const Dental::Geometry& geometry, std::vector<unsigned int>& indices) {
+    auto vertex_count = geometry.vertexArray()->size();
+    for (unsigned int i = 0; i < geometry.numPrimitiveSets(); ++i) {
+      auto primitive_set = geometry.primitiveSet(i);
+      auto elements = std::dynamic_pointer_cast<Dental::DrawElementsUInt>(primitive_set);
+      if (!elements || primitive_set->mode() != Dental::PrimitiveSet::Mode::TRIANGLES) {
+        continue;
+      }
+
+      for (std::size_t j = 0; j + 2 < elements->size(); j += 3) {
+        auto a = (*elements)[j], b = (*elements)[j + 1], c = (*elements)[j + 2];
+        if (a < vertex_count && b < vertex_count && c < vertex_count) {
+          indices.insert(indices.end(), { a, b, c });
+        }
+      }
+    }
+  }
+
+  // 第3i+j项为三角形i对着第j个顶点的边另一侧的三角形; 顶点按位置合并, STL的三角形不共享顶点;
+  // 只记录恰好被两个方向一致的三角形共享的边
+  std::vector<unsigned int> findNeighbors(const std::vector<glm::vec3>& vertices, const std::vector<unsigned int>& indices) {
+    std::map<std::array<float, 3>, unsigned int> positions;
+    std::vector<unsigned int> ids(vertices.size());
+    for (std::size_t i = 0; i < vertices.size(); ++i) {
+      auto& vertex = vertices[i];
+      ids[i] = positions.emplace(std::array<float, 3>{ vertex.x, vertex.y, vertex.z }, (unsigned int)positions.size()).first->second;
+    }
+
+    auto key = [](unsigned int from, unsigned int to) { return (unsigned long long)from << 32 | to; };
+
+    std::unordered_map<unsigned long long, unsigned int> counts;
+    std::unordered_map<unsigned long long, unsigned int> edges;
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+      auto from = ids[indices[i - i % 3 + (i + 1) % 3]];
+      auto to = ids[indices[i - i % 3 + (i + 2) % 3]];
+      ++counts[key(std::min(from, to), std::max(from, to))];
+      edges.emplace(key(from, to), (unsigned int)i / 3);
+    }
+
+    std::vector<unsigned int> neighbors(indices.size(), NO_NEIGHBOR);
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+      auto from = ids[indices[i - i % 3 + (i + 1) % 3]];
+      auto to = ids[indices[i - i % 3 + (i + 2) % 3]];
+      auto itr = edges.find(key(to, from));
+      if (itr != edges.end() && counts[key(std::min(from, to), std::max(from, to))] == 2) {
+        neighbors[i] = itr->second;
+      }
+    }
+    return neighbors;
+  }
+}
+
+namespace Dental {
+  OcclusionCuller::OcclusionCuller() {
+  }
+
+  OcclusionCuller::~OcclusionCuller() {
+  }
+
+  const OcclusionCuller::Occluder* OcclusionCuller::occluder(const GeometryPtr& geometry) {
+    occluders_.erase(std::remove_if(occluders_.begin(), occluders_.end(), [](const Occluder& occluder) {
+      return occluder.geometry.expired();
+    }), occluders_.end());
+
+    auto itr = std::find_if(occluders_.begin(), occluders_.end(), [&](const Occluder& occluder) {
+      return occluder.geometry.lock() == geometry;
+    });
+    if (itr != occluders_.end() && itr->revision == geometry->revision()) {
+      return &*itr;
+    }
+
+    // 顶点不在同一个模型空间时不能作为遮挡体
+    if (geometry->className() != "Geometry") {
+      return nullptr;
+    }
+
+    // 不再用顶点聚类, 聚类后的平均位置会把轮廓向外推; 简化层级保留边界, 还没有生成时先不作为遮挡体
+    const Geometry* source = geometry.get();
+    if (numTriangles(*source) > MAX_OCCLUDER_TRIANGLES) {
+      source = nullptr;
+      for (unsigned int level = 1; geometry->lodsValid() && level <= geometry->lods().size(); ++level) {
+        if (geometry->lodTriangles(level) <= MAX_OCCLUDER_TRIANGLES) {
+          source = &geometry->lodGeometry(level);
+          break;
+        }
+      }
+    }
+
+    // 数据已释放时不能作为遮挡体
+    if (!source || !source->resident()) {
+      return nullptr;
+    }
+
+    Occluder occluder{ geometry, geometry->revision(), {}, {}, {} };
+    collectTriangles(*source, occluder.indices);
+    if (occluder.indices.empty()) {
+      return nullptr;
+    }
+    occluder.vertices.assign(source->vertexArray()->begin(), source->vertexArray()->end());
+    occluder.neighbors = findNeighbors(occluder.vertices, occluder.indices);
+
+    if (itr != occluders_.end()) {
+      *itr = std::move(occluder);
+      return &*itr;
+    }
+
+    occluders_.emplace_back(std::move(occluder));
+    return &occluders_.back();
+  }
+
+  unsigned int OcclusionCuller::apply(std::vector<RenderQueue::Item>& items) {
+    if (items.size() < 2) {
+      return 0;
+    }
+
+    // 同一相机下的项共用投影和视口, 与第一项不同的不参与
+    const auto projection = items.front().info.projection();
+    const auto viewport = items.front().info.viewport();
+    bool perspective = projection[3][3] == 0.f;
+
+    std::vector<std::pair<float, std::size_t>> candidates;
+    for (std::size_t i = 0; i < items.size(); ++i) {
+      auto& item = items[i];
+      // 额外的项与geometry自身的项是同一个模型, 只作为一次遮挡体
+      if (item.extra || item.info.projection() != projection || !sameViewport(item.info.viewport(), viewport)) {
+        continue;
+      }
+
+      const auto& box = item.geometry->localBoundingBox();
+      if (!box.valid()) {
+        continue;
+      }
+
+      auto& mv = item.info.mv();
+      auto center = glm::vec3(mv * glm::vec4(box.center(), 1.f));
+      auto radius = box.radius() * glm::length(glm::vec3(mv[0]));
+      auto size = perspective ? (center.z < 0.f ? radius * projection[1][1] / -center.z : 0.f) :
+                                radius * projection[1][1];
+      if (size >= MIN_OCCLUDER_SIZE) {
+        candidates.emplace_back(size, i);
+      }
+    }
+
+    if (candidates.empty()) {
+      return 0;
+    }
+
+    auto count = std::min<std::size_t>(candidates.size(), MAX_OCCLUDERS);
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(),
+                      [](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first; });
+
+    clear(viewport);
+
+    bool drawn = false;
+    for (std::size_t i = 0; i < count; ++i) {
+      auto& item = items[candidates[i].second];
+      auto occluder = this->occluder(item.geometry);
+      if (!occluder) {
+        continue;
+      }
+
+      rasterize(occluder->vertices, occluder->indices, projection * item.info.mv(), occluder->neighbors);
+      drawn = true;
+    }
+
+    if (!drawn) {
+      return 0;
+    }
+
+    buildHierarchy();
+
+    // 遮挡体也参与测试, 自身的包围盒不会被自己挡住, 但可能被更近的遮挡体挡住
+    // 额外的项随geometry一起移除, 不重复计数
+    std::vector<RenderQueue::Item> visible_items;
+    visible_items.reserve(items.size());
+    unsigned int culled = 0;
+    for (std::size_t i = 0; i < items.size(); ++i) {
+      auto& item = items[i];
+      bool tested = item.info.projection() == projection && sameViewport(item.info.viewport(), viewport);
+      if (tested && !visible(item.geometry->localBoundingBox(), projection * item.info.mv())) {
+        culled += item.extra ? 0 : 1;
+        continue;
+      }
+      visible_items.emplace_back(std::move(item));
+    }
+
+    items.swap(visible_items);
+    return culled;
+  }
+
+  void OcclusionCuller::clear(const Viewport& viewport) {
+    unsigned int height = viewport.width() > 0 ?
+      (unsigned int)std::lround((float)WIDTH * viewport.height() / viewport.width()) : WIDTH;
+    height = std::clamp(height, 1u, (unsigned int)WIDTH);
+
+    levels_.resize(1);
+    levels_[0].width = WIDTH;
+    levels_[0].height = height;
+    levels_[0].depth.assign(WIDTH * height, 1.f);
+  }
+
+  void OcclusionCuller::rasterize(const std::vector<glm::vec3>& vertices, const std::vector<unsigned int>& indices, const glm::mat4& mvp,
+                                  const std::vector<unsigned int>& neighbors) {
+    if (levels_.empty()) {
+      return;
+    }
+
+    auto& level = levels_[0];
+    auto width = (float)level.width;
+    auto height = (float)level.height;
+
+    std::vector<glm::vec3> screen(vertices.size());
+    std::vector<bool> clipped(vertices.size());
+    for (std::size_t i = 0; i < vertices.size(); ++i) {
+      auto clip = mvp * glm::vec4(vertices[i], 1.f);
+      // 跨过近平面的三角形不绘制, 遮挡体少画只会让测试更保守
+      clipped[i] = clip.w <= 1e-6f || clip.z < -clip.w;
+      if (!clipped[i]) {
+        auto ndc = glm::vec3(clip) / clip.w;
+        screen[i] = glm::vec3((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height, ndc.z * 0.5f + 0.5f);
+      }
+    }
+
+    // 屏幕上的朝向, 0为被裁剪或退化
+    std::vector<signed char> facing(indices.size() / 3);
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+      auto ia = indices[i], ib = indices[i + 1], ic = indices[i + 2];
+      if (clipped[ia] || clipped[ib] || clipped[ic]) {
+        continue;
+      }
+
+      auto a = screen[ia], b = screen[ib], c = screen[ic];
+      float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+      facing[i / 3] = area > 0.f ? 1 : (area < 0.f ? -1 : 0);
+    }
+
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+      auto side = facing[i / 3];
+      if (!side) {
+        continue;
+      }
+
+      auto a = screen[indices[i]], b = screen[indices[i + 1]], c = screen[indices[i + 2]];
+      float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+
+      // 轮廓边向内收缩半个像素, 只写入被完全覆盖的像素; 两侧的三角形朝向相同的内部边
+      // 由另一侧的三角形补全覆盖, 不收缩, 否则网格的每条边都留下一条没有深度的缝
+      std::array<bool, 3> outline;
+      for (std::size_t j = 0; j < 3; ++j) {
+        auto neighbor = neighbors.empty() ? NO_NEIGHBOR : neighbors[i + j];
+        outline[j] = neighbor == NO_NEIGHBOR || facing[neighbor] != side;
+      }
+
+      // 顺时针的三角形交换顶点, 统一按逆时针扫描
+      if (area < 0.f) {
+        std::swap(b, c);
+        std::swap(outline[1], outline[2]);
+        area = -area;
+      }
+
+      // 深度取像素内最远处, 遮挡体在任何像素上都不会比真实的模型更近
+      float shrink0 = outline[0] ? 0.5f * (std::abs(c.x - b.x) + std::abs(c.y - b.y)) : 0.f;
+      float shrink1 = outline[1] ? 0.5f * (std::abs(a.x - c.x) + std::abs(a.y - c.y)) : 0.f;
+      float shrink2 = outline[2] ? 0.5f * (std::abs(b.x - a.x) + std::abs(b.y - a.y)) : 0.f;
+      float dzdx = ((b.y - c.y) * a.z + (c.y - a.y) * b.z + (a.y - b.y) * c.z) / area;
+      float dzdy = ((c.x - b.x) * a.z + (a.x - c.x) * b.z + (b.x - a.x) * c.z) / area;
+      float slope = 0.5f * (std::abs(dzdx) + std::abs(dzdy));
+      float farthest = std::max({ a.z, b.z, c.z });
+
+      int min_x = std::max(0, (int)std::floor(std::min({ a.x, b.x, c.x })));
+      int max_x = std::min((int)level.width - 1, (int)std::ceil(std::max({ a.x, b.x, c.x })));
+      int min_y = std::max(0, (int)std::floor(std::min({ a.y, b.y, c.y })));
+      int max_y = std::min((int)level.height - 1, (int)std::ceil(std::max({ a.y, b.y, c.y })));
+
+      for (int y = min_y; y <= max_y; ++y) {
+        float py = y + 0.5f;
+        for (int x = min_x; x <= max_x; ++x) {
+          float px = x + 0.5f;
+          float w0 = (c.x - b.x) * (py - b.y) - (c.y - b.y) * (px - b.x);
+          float w1 = (a.x - c.x) * (py - c.y) - (a.y - c.y) * (px - c.x);
+          float w2 = (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+          if (w0 < shrink0 || w1 < shrink1 || w2 < shrink2) {
+            continue;
+          }
+
+          float depth = std::min((w0 * a.z + w1 * b.z + w2 * c.z) / area + slope, farthest);
+          auto& target = level.depth[y * level.width + x];
+          target = std::min(target, depth);
+        }
+      }
+    }
+  }
+
+  void OcclusionCuller::buildHierarchy() {
+    if (levels_.empty()) {
+      return;
+    }
+
+    levels_.resize(1);
+    while (levels_.back().width > 1 || levels_.back().height > 1) {
+      const auto& source = levels_.back();
+
+      Level level;
+      level.width = (source.width + 1) / 2;
+      level.height = (source.height + 1) / 2;
+      level.depth.resize(level.width * level.height);
+
+      for (unsigned int y = 0; y < level.height; ++y) {
+        for (unsigned int x = 0; x < level.width; ++x) {
+          unsigned int x1 = std::min(x * 2 + 1, source.width - 1);
+          unsigned int y1 = std::min(y * 2 + 1, source.height - 1);
+          level.depth[y * level.width + x] = std::max(
+            std::max(source.depth[y * 2 * source.width + x * 2], source.depth[y * 2 * source.width + x1]),
+            std::max(source.depth[y1 * source.width + x * 2], source.depth[y1 * source.width + x1]));
+        }
+      }
+
+      levels_.emplace_back(std::move(level));
+    }
+  }
+
+  bool OcclusionCuller::visible(const BoundingBox& box, const glm::mat4& mvp) const {
+    if (levels_.empty() || !box.valid()) {
+      return true;
+    }
+
+    const auto& base = levels_[0];
+    glm::vec2 low(FLT_MAX), high(-FLT_MAX);
+    float nearest = FLT_MAX;
+    for (unsigned int i = 0; i < 8; ++i) {
+      auto clip = mvp * glm::vec4(box.corner(i), 1.f);
+      if (clip.w <= 1e-6f || clip.z < -clip.w) {
+        return true;
+      }
+
+      auto ndc = glm::vec3(clip) / clip.w;
+      auto point = glm::vec2((ndc.x * 0.5f + 0.5f) * base.width, (ndc.y * 0.5f + 0.5f) * base.height);
+      low = glm::min(low, point);
+      high = glm::max(high, point);
+      nearest = std::min(nearest, ndc.z * 0.5f + 0.5f);
+    }
+
+    int min_x = std::max(0, (int)std::floor(low.x));
+    int max_x = std::min((int)base.width - 1, (int)std::floor(high.x));
+    int min_y = std::max(0, (int)std::floor(low.y));
+    int max_y = std::min((int)base.height - 1, (int)std::floor(high.y));
+    if (min_x > max_x || min_y > max_y) {
+      return true;
+    }
+
+    // 选择覆盖区域不超过2x2个像素的层
+    unsigned int index = 0;
+    while (index + 1 < levels_.size() && (((max_x - min_x) >> index) > 1 || ((max_y - min_y) >> index) > 1)) {
+      ++index;
+    }
+
+    const auto& level = levels_[index];
+    for (int y = min_y >> index; y <= (max_y >> index); ++y) {
+      for (int x = min_x >> index; x <= (max_x >> index); ++x) {
+        if (nearest <= level.depth[y * level.width + x] + DEPTH_BIAS) {
+          return true;
+        }
+      }
+    }
+
+    return false;
+  }
+}
@@ -2,6 +2,10 @@
 
 #define ENABLE_BUFFER
 
+namespace {
+  unsigned int draw_calls = 0;
+}
+
 namespace Dental {
   unsigned int PrimitiveSet::modeSize() const {
     switch (mode_) {
@@ -24,6 +28,14 @@ namespace Dental {
     return numIndices() / modeSize();
   }
 
+  unsigned int PrimitiveSet::drawCalls() {
+    return draw_calls;
+  }
+
+  void PrimitiveSet::resetStatistics() {
+    draw_calls = 0;
+  }
+
   GLElementArrayObject::GLElementArrayObject() {
     mode_ = GL_POINTS;
     first_ = 0;
@@ -39,6 +51,14 @@ namespace Dental {
   void GLElementArrayObject::bind() {
     if (count_) {
       glDrawArrays(mode_, first_, count_);
+      ++draw_calls;
+    }
+  }
+
+  void GLElementArrayObject::drawInstanced(GLsizei instances) {
+    if (count_ && instances > 0) {
+      glDrawArraysInstanced(mode_, first_, count_, instances);
+      ++draw_calls;
     }
   }
 
@@ -58,72 +78,51 @@ namespace Dental {
     return arrays;
   }
 
-  GLElementBufferObject::GLElementBufferObject(short data_type_size, unsigned long gl_data_type) {
-    profile_.data_type_size = data_type_size;
-    profile_.gl_data_type = gl_data_type;
-
-    mode_ = 0;
-    ebo_ = 0;
-    data_size_ = 0;
-    data_ = 0;
-    dirty_ = true;
+  GLElementBufferObject::GLElementBufferObject(short data_type_size, unsigned long gl_data_type) :
+    GLBufferObject(GL_ELEMENT_ARRAY_BUFFER, data_type_size),
+    gl_data_type_(gl_data_type),
+    mode_(0) {
   }
 
   void GLElementBufferObject::bind(GLenum mode, unsigned long data_size, void* data) {
     mode_ = mode;
-    data_size_ = data_size;
-    data_ = data;
+    bindData(data_size, data);
   }
 
   void GLElementBufferObject::bind() {
-    if (!data_size_) {
-      dirty_ = false;
-      return;
-    }
 #ifdef ENABLE_BUFFER
-    if (!ebo_) {
-      glGenBuffers(1, &ebo_);
-      dirty_ = true;
-    }
+    sync();
+    draw();
+#else
+    glDrawElements(mode_, (GLsizei)data_size_, gl_data_type_, data_);
+    ++draw_calls;
+#endif
+  }
 
-    if (!ebo_) {
+  void GLElementBufferObject::draw() {
+    if (!data_size_ || !buffer_ || streaming()) {
       return;
     }
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+    glDrawElements(mode_, (GLsizei)data_size_, gl_data_type_, 0);
+    ++draw_calls;
+  }
 
-    if (dirty_) {
-      glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)data_size_ * profile_.data_type_size, data_,
-                   GL_STATIC_DRAW);
-      dirty_ = false;
+  void GLElementBufferObject::draw(GLsizei first, GLsizei count) {
+    if (!buffer_ || streaming() || count <= 0 || first + count > data_size_) {
+      return;
     }
 
-    if (data_size_) {
-      glDrawElements(mode_, data_size_, profile_.gl_data_type, 0);
-    }
-#else
-    if (data_size_) {
-      glDrawElements(mode_, data_size_, profile_.gl_data_type, data_);
-    }
-#endif
+    glDrawElements(mode_, count, gl_data_type_, (const void*)((std::size_t)first * data_type_size_));
+    ++draw_calls;
   }
 
-  void GLElementBufferObject::unbind() {
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-  }
-
-  void GLElementBufferObject::release() {
-    if (ebo_) {
-      glDeleteBuffers(1, &ebo_);
-      ebo_ = 0;
+  void GLElementBufferObject::drawInstanced(GLsizei instances) {
+    if (!data_size_ || !buffer_ || streaming() || instances <= 0) {
+      return;
     }
-  }
-
-  void GLElementBufferObject::dirty() {
-    dirty_ = true;
-  }
 
-  bool GLElementBufferObject::valid() {
-    return !dirty_ && data_size_ && ebo_ != 0;
+    glDrawElementsInstanced(mode_, (GLsizei)data_size_, gl_data_type_, 0, instances);
+    ++draw_calls;
   }
 }
\ No newline at end of file
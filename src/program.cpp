@@ -1,7 +1,24 @@
+#include <cstring>
+#include <algorithm>
 #include <glad/glad.h>
 #include <program.h>
+#include <gl_state.h>
+#include <gl_delete_queue.h>
+#include <view_uniform_buffer.h>
 
 namespace {
+  unsigned int skipped_uploads = 0;
+
+  // 数组uniform的名字为name[0]
+  std::string baseName(const char* name) {
+    std::string result(name);
+    auto pos = result.find('[');
+    if (pos != std::string::npos) {
+      result.resize(pos);
+    }
+    return result;
+  }
+
   unsigned int compileShader(unsigned int type, const char* source) {
     unsigned int shader = glCreateShader(type);
     if (!shader) {
@@ -41,12 +58,120 @@ namespace Dental {
     release();
   }
 
-  int Program::attrib_location(const std::string& name) {
-    return glGetAttribLocation(program_, name.c_str());
+  int Program::attrib_location(const std::string& name) const {
+    auto itr = attribs_.find(name);
+    return itr != attribs_.end() ? itr->second.location : -1;
   }
 
-  int Program::uniform_location(const std::string& name) {
-    return glGetUniformLocation(program_, name.c_str());
+  int Program::uniform_location(const std::string& name) const {
+    auto itr = uniforms_.find(name);
+    return itr != uniforms_.end() ? itr->second.location : -1;
+  }
+
+  void Program::reflect() {
+    decltype(uniforms_)().swap(uniforms_);
+    decltype(attribs_)().swap(attribs_);
+
+    GLint max_length = 0;
+    glGetProgramiv(program_, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+    GLint attrib_max_length = 0;
+    glGetProgramiv(program_, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &attrib_max_length);
+    std::vector<char> name(std::max(max_length, attrib_max_length) + 1);
+
+    GLint count = 0;
+    glGetProgramiv(program_, GL_ACTIVE_UNIFORMS, &count);
+    for (GLint i = 0; i < count; ++i) {
+      GLint size = 0;
+      GLenum type = 0;
+      glGetActiveUniform(program_, i, (GLsizei)name.size(), nullptr, &size, &type, name.data());
+      int location = glGetUniformLocation(program_, name.data());
+      // uniform block中的成员没有location
+      if (location == -1) {
+        continue;
+      }
+      uniforms_[baseName(name.data())] = { location, type, size, {} };
+    }
+
+    count = 0;
+    glGetProgramiv(program_, GL_ACTIVE_ATTRIBUTES, &count);
+    for (GLint i = 0; i < count; ++i) {
+      GLint size = 0;
+      GLenum type = 0;
+      glGetActiveAttrib(program_, i, (GLsizei)name.size(), nullptr, &size, &type, name.data());
+      attribs_[name.data()] = { glGetAttribLocation(program_, name.data()), type, size };
+    }
+  }
+
+  Program::UniformInfo* Program::update(const std::string& name, const void* data, unsigned int size) {
+    auto itr = uniforms_.find(name);
+    if (itr == uniforms_.end()) {
+      return nullptr;
+    }
+
+    auto& info = itr->second;
+    if (info.value.size() == size && !std::memcmp(info.value.data(), data, size)) {
+      ++skipped_uploads;
+      return nullptr;
+    }
+
+    info.value.assign((const unsigned char*)data, (const unsigned char*)data + size);
+    return &info;
+  }
+
+  void Program::uniform(const std::string& name, int value) {
+    if (auto info = update(name, &value, sizeof(value))) {
+      glUniform1i(info->location, value);
+    }
+  }
+
+  void Program::uniform(const std::string& name, float value) {
+    if (auto info = update(name, &value, sizeof(value))) {
+      glUniform1f(info->location, value);
+    }
+  }
+
+  void Program::uniform(const std::string& name, const glm::vec2& value) {
+    if (auto info = update(name, &value, sizeof(value))) {
+      glUniform2fv(info->location, 1, glm::value_ptr(value));
+    }
+  }
+
+  void Program::uniform(const std::string& name, const glm::vec3& value) {
+    if (auto info = update(name, &value, sizeof(value))) {
+      glUniform3fv(info->location, 1, glm::value_ptr(value));
+    }
+  }
+
+  void Program::uniform(const std::string& name, const glm::vec4& value) {
+    if (auto info = update(name, &value, sizeof(value))) {
+      glUniform4fv(info->location, 1, glm::value_ptr(value));
+    }
+  }
+
+  void Program::uniform(const std::string& name, const glm::mat3& value) {
+    if (auto info = update(name, &value, sizeof(value))) {
+      glUniformMatrix3fv(info->location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+  }
+
+  void Program::uniform(const std::string& name, const glm::mat4& value) {
+    if (auto info = update(name, &value, sizeof(value))) {
+      glUniformMatrix4fv(info->location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+  }
+
+  void Program::uniform(const Uniform& uniform) {
+    if (auto info = update(uniform.name(), uniform.data(), uniform.size())) {
+      uniform.bind(info->location);
+    }
+  }
+
+  unsigned int Program::skippedUploads() {
+    return skipped_uploads;
+  }
+
+  void Program::resetStatistics() {
+    skipped_uploads = 0;
   }
 
   void Program::create() {
@@ -76,7 +201,13 @@ namespace Dental {
     glDeleteShader(vertex_shader);
     glDeleteShader(fragment_shader);
 
+    GLuint view_block = glGetUniformBlockIndex(program, ViewUniformBuffer::blockName());
+    if (view_block != GL_INVALID_INDEX) {
+      glUniformBlockBinding(program, view_block, ViewUniformBuffer::BINDING);
+    }
+
     program_ = program;
+    reflect();
   }
 
   void Program::bind() {
@@ -94,29 +225,23 @@ namespace Dental {
       }
     }
 
-    glUseProgram(program_);
+    GLState::instance().useProgram(program_);
   }
 
   void Program::bind(const glm::mat4& mv, const glm::mat4& mvp) {
-    int mvp_location = glGetUniformLocation(program_, "uMVP");
-    int mv_location = glGetUniformLocation(program_, "uMV");
-
-    if (mv_location != -1) {
-      glUniformMatrix4fv(mv_location, 1, GL_FALSE, (float*)glm::value_ptr(mv));
-    }
-
-    if (mvp_location != -1) {
-      glUniformMatrix4fv(mvp_location, 1, GL_FALSE, (float*)glm::value_ptr(mvp));
-    }
+    uniform("uMV", mv);
+    uniform("uMVP", mvp);
   }
 
   void Program::unbind() {
-    glUseProgram(0);
+    GLState::instance().useProgram(0);
   }
 
   void Program::release() {
-    glDeleteProgram(program_);
+    GLDeleteQueue::instance().push(GLDeleteQueue::Type::PROGRAM, program_);
     program_ = 0;
+    decltype(uniforms_)().swap(uniforms_);
+    decltype(attribs_)().swap(attribs_);
   }
 
   void Program::dirty() {
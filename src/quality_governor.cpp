@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <cmath>
+#include <quality_governor.h>
+
+namespace {
+  // 帧时间的指数平滑系数
+  const float SMOOTHING = 0.2f;
+
+  // 超过目标该比例时降低分辨率, 低于该比例时逐步恢复;
+  // 开启垂直同步时帧时间不会明显低于目标, 恢复的阈值要略高于目标
+  const float SLOW_RATIO = 1.2f;
+  const float FAST_RATIO = 1.05f;
+}
+
+namespace Dental {
+  QualityGovernor::QualityGovernor() :
+    enabled_(true),
+    interactive_(false),
+    dynamic_resolution_(true),
+    target_frame_time_(1.f / 60.f),
+    min_scale_(0.5f),
+    scale_(1.f),
+    average_frame_time_(0.f),
+    frames_since_adjust_(0) {
+  }
+
+  QualityGovernor::~QualityGovernor() {
+  }
+
+  void QualityGovernor::dynamicResolution(bool dynamic_resolution) {
+    dynamic_resolution_ = dynamic_resolution;
+    scale_ = 1.f;
+    average_frame_time_ = 0.f;
+    frames_since_adjust_ = 0;
+  }
+
+  void QualityGovernor::minScale(float scale) {
+    min_scale_ = std::clamp(scale, SCALE_STEP, 1.f);
+    scale_ = std::max(scale_, min_scale_);
+  }
+
+  void QualityGovernor::update(bool moving) {
+    interactive_ = enabled_ && moving;
+  }
+
+  void QualityGovernor::frameTime(float seconds) {
+    if (!interactive_ || !dynamic_resolution_ || seconds <= 0.f) {
+      return;
+    }
+
+    average_frame_time_ = average_frame_time_ > 0.f ?
+      average_frame_time_ + (seconds - average_frame_time_) * SMOOTHING : seconds;
+
+    // 调整后等几帧, 让平滑后的帧时间反映新的分辨率
+    if (++frames_since_adjust_ < ADJUST_INTERVAL) {
+      return;
+    }
+
+    float scale = scale_;
+    if (average_frame_time_ > target_frame_time_ * SLOW_RATIO) {
+      // 绘制耗时近似与像素数即比例的平方成正比
+      scale *= std::sqrt(target_frame_time_ / average_frame_time_);
+      scale = std::min(scale, scale_ - SCALE_STEP);
+    } else if (average_frame_time_ < target_frame_time_ * FAST_RATIO) {
+      scale += SCALE_STEP;
+    }
+
+    // 按步长取整, 避免离屏目标频繁改变尺寸
+    scale = std::round(scale / SCALE_STEP) * SCALE_STEP;
+    scale = std::clamp(scale, min_scale_, 1.f);
+    if (scale != scale_) {
+      scale_ = scale;
+      frames_since_adjust_ = 0;
+    }
+  }
+
+  float QualityGovernor::resolutionScale() const {
+    if (!interactive_) {
+      return 1.f;
+    }
+    return dynamic_resolution_ ? scale_ : INTERACTIVE_SCALE;
+  }
+
+  Viewport QualityGovernor::scale(const Viewport& viewport, float scale) {
+    if (scale == 1.f) {
+      return viewport;
+    }
+
+    return Viewport(
+      (int)(viewport.x() * scale),
+      (int)(viewport.y() * scale),
+      std::max((int)(viewport.width() * scale), 1),
+      std::max((int)(viewport.height() * scale), 1));
+  }
+}
@@ -10,7 +10,11 @@
 #include <wrap/io_trimesh/export.h>
 
 #include <list>
+#include <sstream>
 #include <reader_writer.h>
+#include <mesh_optimizer.h>
+#include <lod_generator.h>
+#include <ambient_occlusion_baker.h>
 #include <texture.h>
 #include <filesystem>
 
@@ -857,11 +861,11 @@ namespace Dental::ReaderWriter {
     return (supportedExtensions_.count(ext) != 0);
   }
 
-  void WriteOptions::option(std::string parma, std::string value) {
+  void OptionsBase::option(std::string parma, std::string value) {
     (*this)[parma] = value;
   }
 
-  std::string WriteOptions::option(std::string parma) const {
+  std::string OptionsBase::option(std::string parma) const {
     auto itr = find(parma);
     if (itr != end()) {
       return itr->second;
@@ -869,17 +873,45 @@ namespace Dental::ReaderWriter {
     return "";
   }
 
+  void OptionsBase::flagOption(const std::string& parma, bool value) {
+    option(parma, value ? "1" : "0");
+  }
+
+  void ReadOptions::optimizeVertexCache(bool flag) {
+    flagOption("OptimizeVertexCache", flag);
+  }
+
+  void ReadOptions::optimizeVertexFetch(bool flag) {
+    flagOption("OptimizeVertexFetch", flag);
+  }
+
+  void ReadOptions::buildClusters(bool flag) {
+    flagOption("BuildClusters", flag);
+  }
+
+  void ReadOptions::generateLods(bool flag) {
+    flagOption("GenerateLods", flag);
+  }
+
+  void ReadOptions::bakeAmbientOcclusion(bool flag) {
+    flagOption("BakeAmbientOcclusion", flag);
+  }
+
+  void ReadOptions::releaseAfterUpload(bool flag) {
+    flagOption("ReleaseAfterUpload", flag);
+  }
+
   void WriteOptions::binary(bool flag) {
-    option("Binary", flag ? "1" : "0");
+    flagOption("Binary", flag);
   }
 
   //stl文件是否是彩色模式保存
   void WriteOptions::colorMode(bool flag) {
-    option("ColorMode", flag ? "1" : "0");
+    flagOption("ColorMode", flag);
   }
 
   std::tuple<GeometryPtr, Status, std::string>
-  read(const std::string &file_name) {
+  read(const std::string &file_name, const ReadOptions& options) {
     GeometryPtr geometry(std::make_shared<Geometry>());
 
     auto path = std::filesystem::path(file_name);
@@ -896,7 +928,46 @@ namespace Dental::ReaderWriter {
       return { nullptr, Status::ERROR_IN_READING_FILE, error };
     }
 
-    return { geometry, Status::FILE_LOADED, "" };
+    std::stringstream message;
+    if (options.option("OptimizeVertexCache") == "1") {
+      auto statistics = MeshOptimizer::optimizeVertexCache(*geometry);
+      message << file_name << " vertex cache ACMR: " << statistics.acmr_before << " -> " << statistics.acmr_after;
+    }
+
+    // 分簇在簇内保留顶点缓存优化后的顺序
+    auto primitive_set = geometry->primitiveSet();
+    if (options.option("BuildClusters") == "1" && primitive_set &&
+        primitive_set->numPrimitives() >= MeshOptimizer::MIN_CLUSTERED_TRIANGLES) {
+      auto clusters = MeshOptimizer::buildClusters(*geometry);
+      if (message.tellp() > 0) {
+        message << std::endl;
+      }
+      message << file_name << " clusters: " << clusters;
+    }
+
+    // 先重排三角形, 再按新的三角形顺序重排顶点
+    if (options.option("OptimizeVertexFetch") == "1") {
+      auto statistics = MeshOptimizer::optimizeVertexFetch(*geometry);
+      if (message.tellp() > 0) {
+        message << std::endl;
+      }
+      message << file_name << " vertex fetch overfetch: " << statistics.overfetch_before << " -> " << statistics.overfetch_after;
+    }
+
+    // 在释放数据之前复制一份交给后台线程
+    if (options.option("GenerateLods") == "1") {
+      LodGenerator::instance().request(geometry);
+    }
+
+    if (options.option("BakeAmbientOcclusion") == "1") {
+      AmbientOcclusionBaker::instance().request(geometry);
+    }
+
+    if (options.option("ReleaseAfterUpload") == "1") {
+      geometry->residency(Geometry::Residency::RELEASE_AFTER_UPLOAD);
+    }
+
+    return { geometry, Status::FILE_LOADED, message.str() };
   }
 
   std::tuple<Status, std::string>
@@ -906,6 +977,10 @@ namespace Dental::ReaderWriter {
       return { Status::FILE_NOT_HANDLED, file_name + " do not support!"};
     }
 
+    if (!geometry->restore()) {
+      return { Status::ERROR_IN_WRITING_FILE, "geometry's data can not be restored!"};
+    }
+
     size_t size = geometry->vertexArray()->size() / 3;
     if (!size) {
       return { Status::FILE_NOT_HANDLED, "geometry's data is invalid!"};
@@ -4,7 +4,9 @@
 namespace Dental {
   RenderInfo::RenderInfo() : 
     mv_(glm::identity<glm::mat4>()),
-    projection_(glm::identity<glm::mat4>()) {
+    projection_(glm::identity<glm::mat4>()),
+    interactive_(false),
+    ambient_occlusion_(false) {
   }
 
   RenderInfo::~RenderInfo() {
@@ -16,6 +18,8 @@ namespace Dental {
       mv_ = rhs.mv_;
       projection_ = rhs.projection_;
       viewport_ = rhs.viewport_;
+      interactive_ = rhs.interactive_;
+      ambient_occlusion_ = rhs.ambient_occlusion_;
     }
     return *this;
   }
@@ -25,6 +29,8 @@ namespace Dental {
       mv_ = std::move(rhs.mv_);
       projection_ = std::move(rhs.projection_);
       viewport_ = std::move(rhs.viewport_);
+      interactive_ = rhs.interactive_;
+      ambient_occlusion_ = rhs.ambient_occlusion_;
     }
     return *this;
   }
@@ -69,4 +75,8 @@ namespace Dental {
   const Viewport& RenderInfo::viewport() const {
     return viewport_;
   }
+
+  Frustum RenderInfo::frustum() const {
+    return Frustum(projection_ * mv_);
+  }
 }
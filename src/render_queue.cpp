@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <render_queue.h>
+
+namespace {
+  Dental::RenderQueue::Statistics queue_statistics = { 0, 0, 0 };
+}
+
+namespace Dental {
+  RenderQueue::RenderQueue() {
+  }
+
+  RenderQueue::~RenderQueue() {
+  }
+
+  void RenderQueue::push(unsigned int target, const RenderInfo& info, Geometry& geometry) {
+    push(target, info, geometry, geometry.renderTechnique());
+  }
+
+  void RenderQueue::push(unsigned int target, const RenderInfo& info, Geometry& geometry, const RenderTechniquePtr& technique) {
+    if (!technique) {
+      return;
+    }
+
+    auto texture = geometry.texture();
+
+    Item item;
+    item.key.target = target;
+    item.key.blended = geometry.translucent();
+    item.key.program = technique->program(geometry).get();
+    item.key.texture = texture.get();
+    item.key.technique = technique.get();
+    item.info = info;
+    item.geometry = geometry.ptr();
+    item.technique = technique;
+    item.extra = technique != geometry.renderTechnique();
+    items_.emplace_back(std::move(item));
+  }
+
+  void RenderQueue::flush() {
+    // 相同状态的和半透明的保持场景顺序
+    std::stable_sort(items_.begin(), items_.end(), [](const Item& lhs, const Item& rhs) {
+      return lhs.key < rhs.key;
+    });
+
+    const Program* program = nullptr;
+    const Texture* texture = nullptr;
+    for (auto& item : items_) {
+      if (item.key.program != program) {
+        program = item.key.program;
+        ++queue_statistics.program_changes;
+      }
+
+      if (item.key.texture != texture) {
+        texture = item.key.texture;
+        ++queue_statistics.texture_changes;
+      }
+
+      item.technique->apply(item.info, *item.geometry);
+      ++queue_statistics.items;
+    }
+
+    items_.clear();
+  }
+
+  const RenderQueue::Statistics& RenderQueue::statistics() {
+    return queue_statistics;
+  }
+
+  void RenderQueue::resetStatistics() {
+    queue_statistics = { 0, 0, 0 };
+  }
+}
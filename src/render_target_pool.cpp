@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <render_target_pool.h>
+
+namespace Dental {
+  RenderTargetPool::RenderTargetPool() :
+    frame_(0) {
+  }
+
+  RenderTargetPool& RenderTargetPool::instance() {
+    static RenderTargetPool pool;
+    return pool;
+  }
+
+  GLFrameTextureBufferPtr RenderTargetPool::acquire(unsigned int width, unsigned int height,
+                                                    const void* owner, bool* kept) {
+    if (kept) {
+      *kept = false;
+    }
+
+    Target* scratch = nullptr;
+    unsigned int owners = 0;
+    for (auto& target : targets_) {
+      if (target.buffer->width() != width || target.buffer->height() != height) {
+        continue;
+      }
+
+      if (target.owner) {
+        ++owners;
+      }
+
+      if (target.borrowed) {
+        continue;
+      }
+
+      if (owner && target.owner == owner) {
+        target.borrowed = true;
+        target.last_frame = frame_;
+        if (kept) {
+          *kept = true;
+        }
+        return target.buffer;
+      }
+
+      if (!target.owner && !scratch) {
+        scratch = &target;
+      }
+    }
+
+    // 其他owner的目标不被抢占, 否则超过上限后每个owner的内容都在下次借用前被覆盖
+    auto claim = owner && owners < MAX_TARGETS_PER_SIZE ? owner : nullptr;
+    if (scratch) {
+      scratch->borrowed = true;
+      scratch->last_frame = frame_;
+      scratch->owner = claim;
+      return scratch->buffer;
+    }
+
+    auto buffer = std::make_shared<GLFrameTextureBuffer>();
+    buffer->resize(width, height);
+    buffer->attachColor();
+    targets_.push_back({ buffer, true, frame_, claim });
+    return buffer;
+  }
+
+  void RenderTargetPool::release(const GLFrameTextureBufferPtr& target) {
+    for (auto& itr : targets_) {
+      if (itr.buffer == target) {
+        itr.borrowed = false;
+        return;
+      }
+    }
+  }
+
+  void RenderTargetPool::frame() {
+    ++frame_;
+    targets_.erase(std::remove_if(targets_.begin(), targets_.end(), [this](const Target& target) {
+      return !target.borrowed && frame_ - target.last_frame > MAX_IDLE_FRAMES;
+    }), targets_.end());
+  }
+
+  std::size_t RenderTargetPool::memory() const {
+    std::size_t bytes = 0;
+    for (auto& target : targets_) {
+      bytes += (std::size_t)target.buffer->width() * target.buffer->height() * 8;
+    }
+    return bytes;
+  }
+}
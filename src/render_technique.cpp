@@ -1,39 +1,77 @@
+#include <algorithm>
 #include <render_technique.h>
 #include <geometry.h>
 #include <uuid.h>
 #include <camera.h>
+#include <gl_state.h>
+#include <view_uniform_buffer.h>
+#include <render_target_pool.h>
+#include <gl_delete_queue.h>
+#include <edge_extractor.h>
+
+namespace {
+  unsigned int skipped_depth_passes = 0;
+}
 
 namespace Dental {
-  static ProgramPtr createWhiteProgram() {
-    static const char* vertex_source = R"(#version 300 es
-layout (location = 0) in vec3 aPosition;
-layout (location = 1) in vec3 aNormal;
-out vec3 pos;
-out vec3 normal;
-uniform mat4 uMVP;
-uniform mat4 uMV;
-void main() {
-  gl_Position = uMVP * vec4(aPosition, 1.0);
-  vec4 ecPos = uMV * vec4(aPosition, 1.0);
-  mat3 normal_matrix = mat3(uMV);
-  normal = normalize(normal_matrix * aNormal);
-  pos = (ecPos / ecPos.w).xyz;
-})";
+  // 插在顶点着色器的#version之后, objectMatrix()返回对象在geometry内的变换, objectColor()为对象的染色
+  static const char* object_default_source = R"(mat4 objectMatrix() {
+  return mat4(1.0);
+}
+vec4 objectColor() {
+  return vec4(1.0);
+}
+)";
+
+  // 对象编号取变换纹理中的一行, 见BatchGeometry
+  static const char* object_batch_source = R"(layout (location = 4) in float aObject;
+uniform highp sampler2D uTransforms;
+mat4 objectMatrix() {
+  int row = int(aObject + 0.5);
+  return mat4(
+    texelFetch(uTransforms, ivec2(0, row), 0),
+    texelFetch(uTransforms, ivec2(1, row), 0),
+    texelFetch(uTransforms, ivec2(2, row), 0),
+    texelFetch(uTransforms, ivec2(3, row), 0));
+}
+vec4 objectColor() {
+  return vec4(1.0);
+}
+)";
 
-    static const char* fragment_source = R"(#version 300 es
+  // 每个实例的变换和颜色来自divisor为1的顶点属性, 见InstancedGeometry
+  static const char* object_instanced_source = R"(layout (location = 5) in mat4 aInstanceTransform;
+layout (location = 9) in vec4 aInstanceColor;
+mat4 objectMatrix() {
+  return aInstanceTransform;
+}
+vec4 objectColor() {
+  return aInstanceColor;
+}
+)";
+
+  static std::string injectVariant(const std::string& source, ProgramVariant variant) {
+    static const char* object_sources[PROGRAM_VARIANT_COUNT] = {
+      object_default_source, object_batch_source, object_instanced_source
+    };
+    auto pos = source.find('\n');
+    return source.substr(0, pos + 1) + object_sources[(unsigned int)variant] + source.substr(pos + 1);
+  }
+
+  static const char* lighting_fragment_source = R"(#version 300 es
 precision mediump float;
 in vec3 pos;
 in vec3 normal;
+in vec4 tint;
 out vec4 FragColor;
 const vec3 eyePos        = vec3(0.0, 0.0, 0.0);
-const vec3 lightPos      = vec3(0.0, 0.0, 100.0);
 const vec4 cessnaColor   = vec4(1.0, 1.0, 1.0, 1.0);
 const vec4 lightAmbient  = vec4(0.2, 0.2, 0.2, 1.0);
 const vec4 lightDiffuse  = vec4(0.5, 0.5, 0.5, 1.0);
 const vec4 lightSpecular = vec4(0.2, 0.2, 0.2, 1.0);
 void DirectionalLight(in vec3 normal, in vec3 ecPos,
   inout vec4 ambient, inout vec4 diffuse, inout vec4 specular) {
-  vec3 lightDir = normalize(lightPos - ecPos);
+  vec3 lightDir = normalize(uLightPosition.xyz - ecPos);
   vec3 viewDir = normalize(-ecPos);
   bool blin = true;
   if (blin) {
@@ -52,62 +90,91 @@ void main() {
     vec4 diffCol = vec4(0.0);
     vec4 specCol = vec4(0.0);
     DirectionalLight(normal, pos, ambiCol, diffCol, specCol);
-    FragColor = cessnaColor * (ambiCol + diffCol + specCol);
+    FragColor = tint * cessnaColor * (ambiCol + diffCol + specCol);
+})";
+
+  static ProgramPtr createWhiteProgram(ProgramVariant variant) {
+    static const char* vertex_source = R"(#version 300 es
+layout (location = 0) in vec3 aPosition;
+layout (location = 1) in vec3 aNormal;
+out vec3 pos;
+out vec3 normal;
+out vec4 tint;
+uniform mat4 uMV;
+void main() {
+  mat4 mv = uMV * objectMatrix();
+  vec4 ecPos = mv * vec4(aPosition, 1.0);
+  gl_Position = uProjection * ecPos;
+  mat3 normal_matrix = mat3(mv);
+  normal = normalize(normal_matrix * aNormal);
+  pos = (ecPos / ecPos.w).xyz;
+  tint = objectColor();
 })";
-    return std::make_shared<Program>(vertex_source, fragment_source);
+
+    return std::make_shared<Program>(
+      ViewUniformBuffer::inject(injectVariant(vertex_source, variant)),
+      ViewUniformBuffer::inject(lighting_fragment_source));
   }
 
-  static ProgramPtr createColorProgram() {
+  static ProgramPtr createColorProgram(ProgramVariant variant) {
       static const char* vertex_source = R"(#version 300 es
 layout (location = 0) in vec3 aPosition;
 layout (location = 2) in vec4 aColor;
-uniform mat4 uMVP;
+uniform mat4 uMV;
 out vec3 pos;
 out vec4 color;
 void main() {
-  gl_Position = uMVP * vec4(aPosition, 1.0);
-  color = aColor;
+  gl_Position = uProjection * uMV * objectMatrix() * vec4(aPosition, 1.0);
+  color = aColor * objectColor();
 })";
 
     static const char* fragment_source = R"(#version 300 es
 precision mediump float;
-in vec3 color;
+in vec4 color;
 out vec4 FragColor;
 void main() {
     FragColor = color;
 })";
-    return std::make_shared<Program>(vertex_source, fragment_source);
+    return std::make_shared<Program>(
+      ViewUniformBuffer::inject(injectVariant(vertex_source, variant)),
+      fragment_source);
   }
 
-  static ProgramPtr createTextureProgram() {
+  static ProgramPtr createTextureProgram(ProgramVariant variant) {
     static const char* vertex_source = R"(#version 300 es
 layout (location = 0) in vec3 aPosition;
 layout (location = 3) in vec2 aTexCoord;
 out vec3 pos;
 out vec2 texcoord;
-uniform mat4 uMVP;
+out vec4 tint;
+uniform mat4 uMV;
 void main() {
-  gl_Position = uMVP * vec4(aPosition, 1.0);
+  gl_Position = uProjection * uMV * objectMatrix() * vec4(aPosition, 1.0);
   texcoord = aTexCoord.xy;
+  tint = objectColor();
 })";
 
     static const char* fragment_source = R"(#version 300 es
 precision mediump float;
 uniform sampler2D texture0;
+in vec2 texcoord;
+in vec4 tint;
 out vec4 FragColor;
 void main() {
-    FragColor = texture(texture0, texcoord);
+    FragColor = tint * texture(texture0, texcoord);
 })";
-    return std::make_shared<Program>(vertex_source, fragment_source);
+    return std::make_shared<Program>(
+      ViewUniformBuffer::inject(injectVariant(vertex_source, variant)),
+      fragment_source);
   }
 
-  ProgramPtr createBlackProgram() {
+  ProgramPtr createBlackProgram(ProgramVariant variant) {
     static const char* vertex_source = R"(#version 300 es
 layout (location = 0) in vec3 aPosition;
 uniform mat4 uMVP;
 out vec4 pos;
 void main() {
-  pos = uMVP * vec4(aPosition, 1.0);
+  pos = uMVP * objectMatrix() * vec4(aPosition, 1.0);
   gl_Position = pos;
 })";
 
@@ -119,27 +186,30 @@ void main() {
   FragColor = vec4((pos.xyz + 1.0) * 0.5, 1.f);
 })";
 
-    return std::make_shared<Program>(vertex_source, fragment_source);
+    return std::make_shared<Program>(injectVariant(vertex_source, variant), fragment_source);
   }
 
-  ProgramPtr createShadowProgram() {
+  ProgramPtr createShadowProgram(ProgramVariant variant) {
     static const char* vertex_source = R"(#version 300 es
 layout (location = 0) in vec3 aPosition;
 layout (location = 1) in vec3 aNormal;
-uniform mat4 uMVP;
 uniform mat4 uMV;
 uniform mat4 uDepthMVP;
 out vec3 pos;
 out vec3 normal;
 out vec3 frag;
+out vec4 tint;
 void main() {
-  vec4 depth_pos = uDepthMVP * vec4(aPosition, 1.0);
+  mat4 object = objectMatrix();
+  vec4 depth_pos = uDepthMVP * object * vec4(aPosition, 1.0);
   frag = depth_pos.xyz;
-  gl_Position = uMVP * vec4(aPosition, 1.0);
-  vec4 ecPos = uMV * vec4(aPosition, 1.0);
-  mat3 normal_matrix = mat3(uMV);
+  mat4 mv = uMV * object;
+  vec4 ecPos = mv * vec4(aPosition, 1.0);
+  gl_Position = uProjection * ecPos;
+  mat3 normal_matrix = mat3(mv);
   normal = normalize(normal_matrix * aNormal);
   pos = (ecPos / ecPos.w).xyz;
+  tint = objectColor();
 })";
 
     static const char* fragment_source = R"(#version 300 es
@@ -148,15 +218,15 @@ uniform sampler2D texture0;
 in vec3 pos;
 in vec3 normal;
 in vec3 frag;
+in vec4 tint;
 out vec4 FragColor;
-const vec3 lightPos      = vec3(0.0, 0.0, 100.0);
 const vec4 cessnaColor   = vec4(1.0, 1.0, 1.0, 1.0);
 const vec4 lightAmbient  = vec4(0.4, 0.4, 0.4, 1.0);
 const vec4 lightDiffuse  = vec4(0.3, 0.3, 0.3, 1.0);
 const vec4 lightSpecular = vec4(0.1, 0.1, 0.1, 1.0);
 void DirectionalLight(in vec3 normal, in vec3 ecPos,
   inout vec4 ambient, inout vec4 diffuse, inout vec4 specular) {
-  vec3 lightDir = normalize(lightPos - ecPos);
+  vec3 lightDir = normalize(uLightPosition.xyz - ecPos);
   vec3 viewDir = normalize(-ecPos);
   bool blin = true;
   if (blin) {
@@ -199,14 +269,133 @@ void main() {
   vec4 diffCol = vec4(0.0);
   vec4 specCol = vec4(0.0);
   DirectionalLight(normal, pos, ambiCol, diffCol, specCol);
-  vec4 color = cessnaColor * (ambiCol + diffCol + specCol);
+  vec4 color = tint * cessnaColor * (ambiCol + diffCol + specCol);
   FragColor = vec4(pow(color.xyz, vec3(1.0/2.2)), 1.0);
   FragColor.gb *= shadow;
   // FragColor = vec4(color.xyz * shadow, 1.0);
   // FragColor = vec4(shadow, shadow, shadow, 1.0);
 })";
 
-    return std::make_shared<Program>(vertex_source, fragment_source);
+    return std::make_shared<Program>(
+      ViewUniformBuffer::inject(injectVariant(vertex_source, variant)),
+      ViewUniformBuffer::inject(fragment_source));
+  }
+
+  // 标量在顶点着色器中归一化, 片元着色器按颜色表的行号查色
+  static ProgramPtr createScalarProgram() {
+    static const char* vertex_source = R"(#version 300 es
+layout (location = 0) in vec3 aPosition;
+layout (location = 1) in vec3 aNormal;
+layout (location = 10) in float aScalar;
+out vec3 pos;
+out vec3 normal;
+out float scalar;
+uniform mat4 uMV;
+uniform vec2 uScalarRange;
+void main() {
+  vec4 ecPos = uMV * vec4(aPosition, 1.0);
+  gl_Position = uProjection * ecPos;
+  normal = normalize(mat3(uMV) * aNormal);
+  pos = (ecPos / ecPos.w).xyz;
+  float span = uScalarRange.y - uScalarRange.x;
+  scalar = abs(span) > 1e-6 ? (aScalar - uScalarRange.x) / span : 0.0;
+})";
+
+    static const char* fragment_source = R"(#version 300 es
+precision mediump float;
+in vec3 pos;
+in vec3 normal;
+in float scalar;
+out vec4 FragColor;
+uniform sampler2D uColormapTexture;
+uniform int uColormap;
+const vec4 lightAmbient  = vec4(0.4, 0.4, 0.4, 1.0);
+const vec4 lightDiffuse  = vec4(0.5, 0.5, 0.5, 1.0);
+const vec4 lightSpecular = vec4(0.1, 0.1, 0.1, 1.0);
+void main() {
+  // 采样点落在两端texel的中心, 不和边界外插值
+  vec2 size = vec2(textureSize(uColormapTexture, 0));
+  float u = (clamp(scalar, 0.0, 1.0) * (size.x - 1.0) + 0.5) / size.x;
+  float v = (float(uColormap) + 0.5) / size.y;
+  vec4 color = texture(uColormapTexture, vec2(u, v));
+
+  vec3 lightDir = normalize(uLightPosition.xyz - pos);
+  vec3 halfwayDir = normalize(lightDir + normalize(-pos));
+  vec4 specular = pow(max(dot(normal, halfwayDir), 0.0), 16.0) * lightSpecular;
+  vec4 diffuse = lightDiffuse * max(0.0, dot(normal, lightDir));
+  FragColor = vec4((color * (lightAmbient + diffuse) + specular).rgb, color.a);
+})";
+
+    return std::make_shared<Program>(
+      ViewUniformBuffer::inject(vertex_source),
+      ViewUniformBuffer::inject(fragment_source));
+  }
+
+  // 环境光和漫反射乘以烘焙的遮蔽, 凹陷处变暗
+  static ProgramPtr createAmbientOcclusionProgram(ProgramVariant variant) {
+    static const char* vertex_source = R"(#version 300 es
+layout (location = 0) in vec3 aPosition;
+layout (location = 1) in vec3 aNormal;
+layout (location = 11) in float aOcclusion;
+out vec3 pos;
+out vec3 normal;
+out float occlusion;
+out vec4 tint;
+uniform mat4 uMV;
+void main() {
+  mat4 mv = uMV * objectMatrix();
+  vec4 ecPos = mv * vec4(aPosition, 1.0);
+  gl_Position = uProjection * ecPos;
+  normal = normalize(mat3(mv) * aNormal);
+  pos = (ecPos / ecPos.w).xyz;
+  occlusion = aOcclusion;
+  tint = objectColor();
+})";
+
+    static const char* fragment_source = R"(#version 300 es
+precision mediump float;
+in vec3 pos;
+in vec3 normal;
+in float occlusion;
+in vec4 tint;
+out vec4 FragColor;
+const vec4 lightAmbient  = vec4(0.4, 0.4, 0.4, 1.0);
+const vec4 lightDiffuse  = vec4(0.6, 0.6, 0.6, 1.0);
+const vec4 lightSpecular = vec4(0.1, 0.1, 0.1, 1.0);
+void main() {
+  vec3 lightDir = normalize(uLightPosition.xyz - pos);
+  vec3 halfwayDir = normalize(lightDir + normalize(-pos));
+  vec4 specular = pow(max(dot(normal, halfwayDir), 0.0), 16.0) * lightSpecular;
+  vec4 diffuse = lightDiffuse * max(0.0, dot(normal, lightDir));
+  FragColor = vec4((tint * (lightAmbient + diffuse) * occlusion + specular).rgb, 1.0);
+})";
+
+    return std::make_shared<Program>(
+      ViewUniformBuffer::inject(injectVariant(vertex_source, variant)),
+      ViewUniformBuffer::inject(fragment_source));
+  }
+
+  // 边的纯色绘制, 向相机方向稍微偏移深度, 不与所在的三角形争夺深度
+  static ProgramPtr createEdgeProgram(ProgramVariant variant) {
+    static const char* vertex_source = R"(#version 300 es
+layout (location = 0) in vec3 aPosition;
+uniform mat4 uMV;
+void main() {
+  gl_Position = uProjection * uMV * objectMatrix() * vec4(aPosition, 1.0);
+  gl_Position.z -= 0.0002 * gl_Position.w;
+})";
+
+    static const char* fragment_source = R"(#version 300 es
+precision mediump float;
+out vec4 FragColor;
+uniform vec4 uColor;
+void main() {
+  FragColor = uColor;
+})";
+
+    return std::make_shared<Program>(
+      ViewUniformBuffer::inject(injectVariant(vertex_source, variant)),
+      fragment_source);
   }
 
   ProgramPool& ProgramPool::instance() {
@@ -229,12 +418,31 @@ void main() {
     return program;
   }
 
+  ProgramVariants ProgramPool::variants(const std::string& name) {
+    ProgramVariants programs;
+    for (unsigned int i = 0; i < PROGRAM_VARIANT_COUNT; ++i) {
+      programs[i] = (*this)[variantName(name, (ProgramVariant)i)];
+    }
+    return programs;
+  }
+
+  std::string ProgramPool::variantName(const std::string& name, ProgramVariant variant) {
+    static const char* suffixes[PROGRAM_VARIANT_COUNT] = { "", "_batch", "_instanced" };
+    return name + suffixes[(unsigned int)variant];
+  }
+
   ProgramPool::ProgramPool() {
-    emplace("white", createWhiteProgram());
-    emplace("color", createColorProgram());
-    emplace("texture", createTextureProgram());
-    emplace("black", createBlackProgram());
-    emplace("shadow", createShadowProgram());
+    for (unsigned int i = 0; i < PROGRAM_VARIANT_COUNT; ++i) {
+      auto variant = (ProgramVariant)i;
+      emplace(variantName("white", variant), createWhiteProgram(variant));
+      emplace(variantName("color", variant), createColorProgram(variant));
+      emplace(variantName("texture", variant), createTextureProgram(variant));
+      emplace(variantName("black", variant), createBlackProgram(variant));
+      emplace(variantName("shadow", variant), createShadowProgram(variant));
+      emplace(variantName("ambient_occlusion", variant), createAmbientOcclusionProgram(variant));
+      emplace(variantName("edge", variant), createEdgeProgram(variant));
+    }
+    emplace("scalar", createScalarProgram());
   }
 
   RenderTechnique::RenderTechnique(const std::string& name) :
@@ -248,8 +456,8 @@ void main() {
 
   UniformPtr RenderTechnique::uniform(const std::string& name) const {
     for (auto& itr : uniforms_) {
-      if (itr.first->name() == name)
-        return itr.first;
+      if (itr->name() == name)
+        return itr;
     }
     return nullptr;
   }
@@ -257,13 +465,13 @@ void main() {
   void RenderTechnique::addUniform(const UniformPtr& uniform) {
     UniformPtr result = this->uniform(uniform->name());
     if (!result) {
-      uniforms_.emplace(uniform, -1);
+      uniforms_.emplace(uniform);
     }
   }
 
   void RenderTechnique::removeUniform(const std::string& name) {
     for (auto itr = uniforms_.begin(); itr != uniforms_.end(); ++itr) {
-      if (itr->first->name() == name) {
+      if ((*itr)->name() == name) {
         uniforms_.erase(itr);
         return;
       }
@@ -274,49 +482,85 @@ void main() {
     uniforms_.clear();
   }
 
-  void RenderTechnique::apply(RenderInfo& info, Geometry& geometry) {
-    auto& program = this->program();
+  const ProgramPtr& RenderTechnique::variant(const ProgramVariants& programs, const Geometry& geometry) {
+    return programs[(unsigned int)geometry.programVariant()];
+  }
+
+  void RenderTechnique::bind(const ProgramPtr& program, RenderInfo& info, Geometry& geometry) {
     program->bind();
     program->bind(info.mv(), info.mvp());
+    geometry.bindVariant(*program);
+  }
 
+  void RenderTechnique::apply(RenderInfo& info, Geometry& geometry) {
+    auto& program = this->program();
+    bind(program, info, geometry);
+
+    // 位置由program的反射表提供, 切换program后依然有效
     for (auto& itr : uniforms_) {
-      if (itr.second == -1) {
-        itr.second = program->uniform_location(itr.first->name().c_str());
-      }
-      itr.first->bind(itr.second);
+      program->uniform(*itr);
     }
 
     geometry.render();
   }
 
-  DefaultRenderTechnique::DefaultRenderTechnique() : RenderTechnique("Default") {
+  DefaultRenderTechnique::DefaultRenderTechnique() : RenderTechnique("Default"),
+    white_programs_(ProgramPool::instance().variants("white")),
+    color_programs_(ProgramPool::instance().variants("color")),
+    texture_programs_(ProgramPool::instance().variants("texture")) {
+  }
+
+  const ProgramPtr& DefaultRenderTechnique::program(const Geometry& geometry) {
+    // 数据释放后数组为空, 按GL缓冲中的元素个数判断
+    if (geometry.texcoordArray()->numElements() && geometry.texture()) {
+      return variant(texture_programs_, geometry);
+    } else if (geometry.colorArray()->numElements()) {
+      return variant(color_programs_, geometry);
+    }
+    return variant(white_programs_, geometry);
   }
 
   void DefaultRenderTechnique::apply(RenderInfo& info, Geometry& geometry) {
-    if (geometry.texcoordArray()->size() && geometry.texture()) {
-      program_ = ProgramPool::instance()["texture"];
-      if (uniform("texture0")) {
-        addUniform(std::make_shared<UniformInt>("texture0", 0));
-      }
-    } else if (geometry.colorArray()->size()) {
-      program_ = ProgramPool::instance()["color"];
-    } else {
-      program_ = ProgramPool::instance()["white"];
+    program_ = program(geometry);
+    if (program_ == variant(texture_programs_, geometry) && !uniform("texture0")) {
+      addUniform(std::make_shared<UniformInt>("texture0", 0));
     }
     RenderTechnique::apply(info, geometry);
   }
 
   ShadowRenderTechnique::ShadowRenderTechnique() :
     RenderTechnique("Shadow"), 
-    size_(1024),
-    mv_(glm::identity<glm::mat4>()) {
+    depth_geometry_(nullptr),
+    depth_revision_(0),
+    depth_mvp_(glm::identity<glm::mat4>()),
+    depth_programs_(ProgramPool::instance().variants("black")),
+    shadow_programs_(ProgramPool::instance().variants("shadow")),
+    color_programs_(ProgramPool::instance().variants("color")),
+    white_programs_(ProgramPool::instance().variants("white")),
+    occlusion_programs_(ProgramPool::instance().variants("ambient_occlusion")),
+    mv_(glm::identity<glm::mat4>()),
+    size_(1024) {
     uniform_tex_ = std::make_shared<UniformInt>("texture0", 0);
     uniform_mvp_ = std::make_shared<UniformMat4>("uDepthMVP", glm::identity<glm::mat4>());
-    frambuffer.resize(size_, size_);
-    frambuffer.attachColor();
   }
 
-  void ShadowRenderTechnique::renderDepth(RenderInfo& info, Geometry& geometry) {
+  int ShadowRenderTechnique::shadowMapSize(const Viewport& viewport) {
+    int size = MIN_SIZE;
+    while (size < MAX_SIZE && size * 2 <= std::max(viewport.width(), viewport.height())) {
+      size *= 2;
+    }
+    return size;
+  }
+
+  unsigned int ShadowRenderTechnique::skippedDepthPasses() {
+    return skipped_depth_passes;
+  }
+
+  void ShadowRenderTechnique::resetStatistics() {
+    skipped_depth_passes = 0;
+  }
+
+  RenderInfo ShadowRenderTechnique::depthRenderInfo(Geometry& geometry) const {
     BoundingSphere sphere = geometry.boundingSphere();
     auto center = sphere.center();
     auto radius = sphere.radius();
@@ -329,40 +573,45 @@ void main() {
     mv *= mv_;
 
     RenderInfo depth_render_info;
-    depth_render_info.viewport(Viewport(0.f, 0.f, (float)frambuffer.width(), (float)frambuffer.height()));
+    depth_render_info.viewport(Viewport(0.f, 0.f, (float)size_, (float)size_));
     depth_render_info.mvp(
       mv,
       glm::ortho(-half_size, half_size, -half_size, half_size, -half_size, half_size));
+    return depth_render_info;
+  }
 
-    uniform_mvp_->value<glm::mat4>(depth_render_info.mvp());
-
-    program_ = ProgramPool::instance()["black"];
+  void ShadowRenderTechnique::renderDepth(RenderInfo& info, RenderInfo& depth_render_info, Geometry& geometry) {
+    program_ = variant(depth_programs_, geometry);
 
-    frambuffer.bind();
+    // 结束后绑定回调用者的帧缓冲, 可能是离屏目标
+    auto framebuffer = GLState::instance().drawFramebuffer();
+    frambuffer_->bind();
 
     depth_render_info.viewport().apply();
     glClearColor(0.f, 0.f, 0.f, 1.f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    program_->bind();
-    program_->bind(depth_render_info.mv(), depth_render_info.mvp());
+    bind(program_, depth_render_info, geometry);
+
+    // 簇的裁剪结果只对当前视角有效, 深度图需要完整的模型
+    auto cluster_culling = geometry.clusterCulling();
+    geometry.clusterCulling(false);
     geometry.render();
+    geometry.clusterCulling(cluster_culling);
 
-    frambuffer.unbind();
+    GLState::instance().bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
 
     info.viewport().apply();
     // frambuffer.blit(0, 0, 400, 400);
   }
 
   void ShadowRenderTechnique::renderShadow(RenderInfo& info, Geometry& geometry) {
-    program_ = ProgramPool::instance()["shadow"];
-    program_->bind();
-    program_->bind(info.mv(), info.mvp());
+    program_ = variant(shadow_programs_, geometry);
+    bind(program_, info, geometry);
 
-    uniform_mvp_->bind(program_->uniform_location("uDepthMVP"));
-    uniform_tex_->bind(program_->uniform_location("texture0"));
+    program_->uniform(*uniform_mvp_);
+    program_->uniform(*uniform_tex_);
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, frambuffer.depth());
+    GLState::instance().bindTexture(0, frambuffer_->depth());
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
@@ -371,11 +620,216 @@ void main() {
 
     geometry.render();
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::instance().bindTexture(0, 0);
+  }
+
+  void ShadowRenderTechnique::renderPreview(RenderInfo& info, Geometry& geometry) {
+    // 有烘焙的遮蔽时用它代替阴影提供深度感
+    if (info.ambientOcclusion() && geometry.occlusionArray()) {
+      AmbientOcclusionRenderTechnique::render(info, geometry, occlusion_programs_);
+      program_ = variant(occlusion_programs_, geometry);
+      return;
+    }
+
+    program_ = variant(geometry.colorArray()->numElements() ? color_programs_ : white_programs_, geometry);
+    bind(program_, info, geometry);
+
+    geometry.render();
   }
 
   void ShadowRenderTechnique::apply(RenderInfo& info, Geometry& geometry) {
-    renderDepth(info, geometry);
+    // 烘焙的遮蔽到达后静止的帧也用它绘制, 不再绘制深度图
+    if (info.interactive() || (info.ambientOcclusion() && geometry.occlusionArray())) {
+      renderPreview(info, geometry);
+      return;
+    }
+
+    size_ = shadowMapSize(info.viewport());
+
+    auto depth_render_info = depthRenderInfo(geometry);
+    uniform_mvp_->value<glm::mat4>(depth_render_info.mvp());
+
+    bool kept = false;
+    frambuffer_ = RenderTargetPool::instance().acquire(size_, size_, this, &kept);
+
+    // 深度图只依赖顶点和插入方向, 只旋转视角时不需要重新绘制
+    if (kept && depth_geometry_ == &geometry && depth_revision_ == geometry.revision() &&
+        depth_mvp_ == depth_render_info.mvp()) {
+      ++skipped_depth_passes;
+    } else {
+      renderDepth(info, depth_render_info, geometry);
+      // 上传完之前没有画出深度, 下次重新绘制
+      depth_geometry_ = geometry.uploaded() ? &geometry : nullptr;
+      depth_revision_ = geometry.revision();
+      depth_mvp_ = depth_render_info.mvp();
+    }
+
     renderShadow(info, geometry);
+
+    RenderTargetPool::instance().release(frambuffer_);
+    frambuffer_ = nullptr;
+  }
+
+  ScalarRenderTechnique::ScalarRenderTechnique() : RenderTechnique("Scalar"),
+    colormap_texture_(0) {
+    program_ = ProgramPool::instance()["scalar"];
+
+    uniform_range_ = std::make_shared<UniformVec2>("uScalarRange", glm::vec2(0.f, 1.f));
+    uniform_colormap_ = std::make_shared<UniformInt>("uColormap", (int)Colormap::RAINBOW);
+    uniform_texture_ = std::make_shared<UniformInt>("uColormapTexture", (int)COLORMAP_UNIT);
+    addUniform(uniform_range_);
+    addUniform(uniform_colormap_);
+    addUniform(uniform_texture_);
   }
-}
\ No newline at end of file
+
+  ScalarRenderTechnique::~ScalarRenderTechnique() {
+    GLDeleteQueue::instance().push(GLDeleteQueue::Type::TEXTURE, colormap_texture_);
+  }
+
+  void ScalarRenderTechnique::range(float min, float max) {
+    uniform_range_->value<glm::vec2>(glm::vec2(min, max));
+  }
+
+  glm::vec2 ScalarRenderTechnique::range() const {
+    return uniform_range_->value<glm::vec2>();
+  }
+
+  void ScalarRenderTechnique::colormap(Colormap colormap) {
+    uniform_colormap_->value<int>((int)colormap);
+  }
+
+  ScalarRenderTechnique::Colormap ScalarRenderTechnique::colormap() const {
+    return (Colormap)uniform_colormap_->value<int>();
+  }
+
+  glm::vec4 ScalarRenderTechnique::colormapColor(Colormap colormap, float t) {
+    struct Stop {
+      float t;
+      glm::vec3 color;
+    };
+
+    static const std::vector<Stop> rainbow = {
+      { 0.f,   { 0.f, 0.f, 1.f } },
+      { 0.25f, { 0.f, 1.f, 1.f } },
+      { 0.5f,  { 0.f, 1.f, 0.f } },
+      { 0.75f, { 1.f, 1.f, 0.f } },
+      { 1.f,   { 1.f, 0.f, 0.f } }
+    };
+    static const std::vector<Stop> heat = {
+      { 0.f,   { 0.f, 0.f, 0.f } },
+      { 0.4f,  { 0.8f, 0.f, 0.f } },
+      { 0.75f, { 1.f, 0.8f, 0.f } },
+      { 1.f,   { 1.f, 1.f, 1.f } }
+    };
+    // 发散型, 中间为灰白, 适合有正负的距离
+    static const std::vector<Stop> cool_warm = {
+      { 0.f,   { 0.23f, 0.30f, 0.75f } },
+      { 0.5f,  { 0.87f, 0.87f, 0.87f } },
+      { 1.f,   { 0.71f, 0.02f, 0.15f } }
+    };
+
+    auto& stops = colormap == Colormap::HEAT ? heat : (colormap == Colormap::COOL_WARM ? cool_warm : rainbow);
+
+    t = std::clamp(t, 0.f, 1.f);
+    for (std::size_t i = 1; i < stops.size(); ++i) {
+      if (t <= stops[i].t) {
+        auto f = (t - stops[i - 1].t) / (stops[i].t - stops[i - 1].t);
+        return glm::vec4(glm::mix(stops[i - 1].color, stops[i].color, f), 1.f);
+      }
+    }
+    return glm::vec4(stops.back().color, 1.f);
+  }
+
+  unsigned int ScalarRenderTechnique::colormapTexture() {
+    if (colormap_texture_) {
+      return colormap_texture_;
+    }
+
+    // 每行一个颜色表
+    std::vector<unsigned char> pixels(COLORMAP_SIZE * COLORMAP_COUNT * 4);
+    for (unsigned int row = 0; row < COLORMAP_COUNT; ++row) {
+      for (unsigned int i = 0; i < COLORMAP_SIZE; ++i) {
+        auto color = colormapColor((Colormap)row, i / (float)(COLORMAP_SIZE - 1)) * 255.f + 0.5f;
+        auto pixel = &pixels[(row * COLORMAP_SIZE + i) * 4];
+        pixel[0] = (unsigned char)color.r;
+        pixel[1] = (unsigned char)color.g;
+        pixel[2] = (unsigned char)color.b;
+        pixel[3] = (unsigned char)color.a;
+      }
+    }
+
+    glGenTextures(1, &colormap_texture_);
+    GLState::instance().bindTexture(COLORMAP_UNIT, colormap_texture_);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, COLORMAP_SIZE, COLORMAP_COUNT, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return colormap_texture_;
+  }
+
+  void ScalarRenderTechnique::apply(RenderInfo& info, Geometry& geometry) {
+    GLState::instance().bindTexture(COLORMAP_UNIT, colormapTexture());
+    RenderTechnique::apply(info, geometry);
+  }
+
+  AmbientOcclusionRenderTechnique::AmbientOcclusionRenderTechnique() : RenderTechnique("AmbientOcclusion"),
+    programs_(ProgramPool::instance().variants("ambient_occlusion")) {
+  }
+
+  void AmbientOcclusionRenderTechnique::render(RenderInfo& info, Geometry& geometry, const ProgramVariants& programs) {
+    bind(variant(programs, geometry), info, geometry);
+
+    // 没有遮蔽数组时(如尚未烘焙的简化层级)读取该常量, 按不遮挡绘制
+    glVertexAttrib1f((GLuint)Geometry::Attrib::OCCLUSION, 1.f);
+
+    geometry.render();
+  }
+
+  void AmbientOcclusionRenderTechnique::apply(RenderInfo& info, Geometry& geometry) {
+    program_ = variant(programs_, geometry);
+    render(info, geometry, programs_);
+  }
+
+  EdgeRenderTechnique::EdgeRenderTechnique() : RenderTechnique("Edge"),
+    overlays_(1u << (unsigned int)Geometry::Overlay::EDGES),
+    programs_(ProgramPool::instance().variants("edge")) {
+
+    uniform_color_ = std::make_shared<UniformVec4>("uColor", glm::vec4(0.f, 0.f, 0.f, 1.f));
+    addUniform(uniform_color_);
+  }
+
+  void EdgeRenderTechnique::apply(RenderInfo& info, Geometry& geometry) {
+    if (!overlays_) {
+      return;
+    }
+
+    // 在后台提取, 完成之前不画; 修改后旧的边可能引用不存在的顶点
+    if (!geometry.overlaysValid()) {
+      EdgeExtractor::instance().request(geometry.ptr());
+      return;
+    }
+
+    // 先画的线在深度相同处优先, 边界和折边画在线框之前
+    static const glm::vec4 colors[Geometry::OVERLAY_COUNT] = {
+      { 0.25f, 0.25f, 0.25f, 1.f },
+      { 0.9f, 0.15f, 0.1f, 1.f },
+      { 0.1f, 0.45f, 0.95f, 1.f }
+    };
+
+    program_ = variant(programs_, geometry);
+    bind(program_, info, geometry);
+    for (int i = (int)Geometry::OVERLAY_COUNT - 1; i >= 0; --i) {
+      auto overlay = (Geometry::Overlay)i;
+
+      // 线框的线数约为三角形的1.5倍, 交互时只画边界和折边
+      if (!(overlays_ & (1u << i)) || (overlay == Geometry::Overlay::EDGES && info.interactive())) {
+        continue;
+      }
+
+      uniform_color_->value<glm::vec4>(colors[i]);
+      program_->uniform(*uniform_color_);
+      geometry.renderOverlay(overlay);
+    }
+  }
+}
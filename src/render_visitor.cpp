@@ -1,11 +1,23 @@
+#include <algorithm>
 #include <render_visitor.h>
 #include <geometry.h>
 #include <node.h>
+#include <camera.h>
+#include <quality_governor.h>
+
+namespace {
+  Dental::RenderVisitor::CullStatistics cull_statistics = { 0, 0, 0, 0, 0, 0 };
+}
 
 namespace Dental {
-  RenderVisitor::RenderVisitor(RenderInfoPtr& render_info) :
+  RenderVisitor::RenderVisitor(RenderInfoPtr& render_info, const ViewUniformBufferPtr& view_uniform_buffer) :
     Visitor(),
-    render_info_(render_info) {
+    render_info_(render_info),
+    view_uniform_buffer_(view_uniform_buffer),
+    target_(0),
+    culling_(true),
+    resolution_scale_(1.f),
+    occlusion_culling_(true) {
   }
 
   RenderVisitor::~RenderVisitor() {
@@ -24,9 +36,10 @@ namespace Dental {
   }
 
   void RenderVisitor::pushViewport(const Viewport& viewport) {
-    Visitor::pushViewport(viewport);
-    render_info_->viewport(viewport);
-    viewport.apply();
+    auto scaled = QualityGovernor::scale(viewport, resolution_scale_);
+    Visitor::pushViewport(scaled);
+    render_info_->viewport(scaled);
+    scaled.apply();
   }
 
   void RenderVisitor::popViewport() {
@@ -38,13 +51,167 @@ namespace Dental {
     }
   }
 
+  void RenderVisitor::apply(Camera& camera) {
+    // 外层相机已收集的绘制使用外层的View block
+    flush();
+    ++target_;
+
+    if (!view_uniform_buffer_) {
+      Visitor::apply(camera);
+      flush();
+      return;
+    }
+
+    // 每个相机只更新一次View block
+    views_.push(mvs_.empty() ? camera.mv() : mvs_.top() * camera.mv());
+    view_uniform_buffer_->update(camera.projection(), views_.top(),
+                                 QualityGovernor::scale(camera.viewport(), resolution_scale_));
+    view_uniform_buffer_->bind();
+
+    Visitor::apply(camera);
+
+    flush();
+
+    views_.pop();
+    if (!views_.empty()) {
+      view_uniform_buffer_->update(projections_.top(), views_.top(), viewports_.top());
+      view_uniform_buffer_->bind();
+    }
+  }
+
+  void RenderVisitor::apply(Node& node) {
+    pushMV(node.mv());
+
+    // 节点的包围球位于其geometry的父空间, 整体在视锥外时跳过所有geometry
+    if (culling_) {
+      Frustum frustum(render_info_->projection() * mvs_.top());
+      if (frustum.test(node.boundingSphere()) == Frustum::Result::OUTSIDE) {
+        cull_statistics.culled += node.numGeometry();
+        popMV();
+        return;
+      }
+    }
+
+    node.traverse(*this);
+    popMV();
+  }
+
   void RenderVisitor::apply(Geometry& geometry) {
+    if (culling_ && !mvs_.empty()) {
+      Frustum frustum(render_info_->projection() * mvs_.top());
+      auto result = frustum.test(geometry.boundingSphere());
+
+      // 包围球与视锥相交时再用模型空间中更紧的包围盒判断
+      if (result == Frustum::Result::INTERSECT) {
+        Frustum local(render_info_->projection() * mvs_.top() * geometry.mv());
+        result = local.test(geometry.localBoundingBox());
+      }
+
+      if (result == Frustum::Result::OUTSIDE) {
+        ++cull_statistics.culled;
+        return;
+      }
+    }
+
     pushMV(geometry.mv());
+
+    // 簇只对原模型有效
+    auto& drawn = selectLod(geometry, mvs_.top());
+    if (&drawn == &geometry && !geometry.clusters().empty() && !cullClusters(geometry, mvs_.top())) {
+      ++cull_statistics.culled;
+      popMV();
+      return;
+    }
+
+    ++cull_statistics.drawn;
+    if (&drawn != &geometry) {
+      ++cull_statistics.simplified;
+    }
     render_info_->mv(mvs_.top());
-    auto render_technique = geometry.renderTechnique();
-    if (render_technique) {
-      render_technique->apply(*render_info_, geometry);
+    queue_.push(target_, *render_info_, drawn);
+    if (edge_technique_ && &drawn == &geometry) {
+      queue_.push(target_, *render_info_, geometry, edge_technique_);
     }
     popMV();
   }
+
+  void RenderVisitor::flush() {
+    if (culling_ && occlusion_culling_) {
+      cull_statistics.occluded += occlusion_culler_.apply(queue_.items());
+    }
+    queue_.flush();
+  }
+
+  Geometry& RenderVisitor::selectLod(Geometry& geometry, const glm::mat4& mv) {
+    if (!geometry.lodsValid()) {
+      return geometry;
+    }
+
+    const auto& box = geometry.localBoundingBox();
+    if (!box.valid()) {
+      return geometry;
+    }
+
+    // 包围球投影到屏幕上的像素面积
+    auto& projection = render_info_->projection();
+    auto center = glm::vec3(mv * glm::vec4(box.center(), 1.f));
+    auto radius = box.radius() * glm::length(glm::vec3(mv[0])) * projection[1][1] * render_info_->viewport().height() * 0.5f;
+    if (projection[3][3] == 0.f) {
+      // 视点在包围球内时使用原模型
+      if (-center.z <= box.radius() * glm::length(glm::vec3(mv[0]))) {
+        geometry.lod(0);
+        return geometry;
+      }
+      radius /= -center.z;
+    }
+    float area = glm::pi<float>() * radius * radius;
+
+    auto levels = (unsigned int)geometry.lods().size();
+    auto select = [&](float area) {
+      unsigned int level = 0;
+      while (level < levels && geometry.lodTriangles(level) * LOD_PIXELS_PER_TRIANGLE > area) {
+        ++level;
+      }
+      return level;
+    };
+
+    // 面积在容差范围内变化时保持当前层级
+    auto finer = select(area * LOD_HYSTERESIS);
+    auto coarser = select(area / LOD_HYSTERESIS);
+    geometry.lod(std::clamp(geometry.lod(), finer, coarser));
+
+    auto& lod = geometry.lodGeometry(geometry.lod());
+    if (&lod != &geometry && lod.renderTechnique() != geometry.renderTechnique()) {
+      lod.renderTechnique(geometry.renderTechnique());
+    }
+    return lod;
+  }
+
+  bool RenderVisitor::cullClusters(Geometry& geometry, const glm::mat4& mv) {
+    if (!culling_) {
+      geometry.uncullClusters();
+      return true;
+    }
+
+    // 透视投影用模型空间中的视点, 正交投影用视线方向
+    auto& projection = render_info_->projection();
+    bool perspective = projection[3][3] == 0.f;
+    auto inverse = glm::inverse(mv);
+    auto eye = perspective ? glm::vec3(inverse * glm::vec4(0.f, 0.f, 0.f, 1.f)) :
+                             glm::normalize(glm::vec3(inverse * glm::vec4(0.f, 0.f, -1.f, 0.f)));
+
+    auto total = (unsigned int)geometry.clusters().size();
+    auto visible = geometry.cullClusters(Frustum(projection * mv), eye, perspective);
+    cull_statistics.clusters_drawn += visible;
+    cull_statistics.clusters_culled += total - visible;
+    return visible > 0;
+  }
+
+  const RenderVisitor::CullStatistics& RenderVisitor::statistics() {
+    return cull_statistics;
+  }
+
+  void RenderVisitor::resetStatistics() {
+    cull_statistics = { 0, 0, 0, 0, 0, 0 };
+  }
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include <texture.h>
 #include <glad/glad.h>
 #include <image_library.h>
+#include <gl_state.h>
 
 namespace {
   bool check_mipmaped(GLint filter) {
@@ -55,8 +56,7 @@ namespace Dental {
       }
     }
 
-    glActiveTexture(GL_TEXTURE0 + target_);
-    glBindTexture(GL_TEXTURE_2D, id_);
+    GLState::instance().bindTexture(target_, id_);
 
     if (!dirty_) {
       return;
@@ -82,8 +82,7 @@ namespace Dental {
   }
 
   void TextureGLObject::unbind() {
-    glActiveTexture(GL_TEXTURE0 + target_);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::instance().bindTexture(target_, 0);
   }
 
   void TextureGLObject::release() {
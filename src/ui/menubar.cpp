@@ -1,7 +1,9 @@
 #include <iostream>
 #include <filesystem>
+#include <glm/gtx/transform.hpp>
 #include <engine.h>
 #include <reader_writer.h>
+#include <batch_geometry.h>
 #include <ui/menubar.h>
 #include <GLFW/glfw3.h>
 #include "../external/imgui/imgui.h"
@@ -9,7 +11,15 @@
 
 namespace Dental::UI {
   MenuBar::MenuBar(Engine& engine, const std::string& name, bool visible) :
-    View(engine, name, visible) {
+    View(engine, name, visible),
+    optimize_vertex_cache_(true),
+    optimize_vertex_fetch_(true),
+    build_clusters_(true),
+    generate_lods_(true),
+    bake_ambient_occlusion_(false),
+    release_after_upload_(false),
+    batch_small_geometries_(false),
+    batch_technique_(std::make_shared<ShadowRenderTechnique>()) {
   }
 
   void MenuBar::render() {
@@ -24,6 +34,22 @@ namespace Dental::UI {
           ifd::FileDialog::Instance().Open("ImportFileDialog", "Import File", filters);
         }
 
+        if (ImGui::MenuItem("Place Component")) {
+          const char* filters = "support files (*.stl *.ply *.obj){.stl,.ply,.obj}";
+          ifd::FileDialog::Instance().Open("PlaceComponentDialog", "Place Component", filters);
+        }
+
+        if (ImGui::BeginMenu("Import Options")) {
+          ImGui::MenuItem("Optimize Vertex Cache", nullptr, &optimize_vertex_cache_);
+          ImGui::MenuItem("Optimize Vertex Fetch", nullptr, &optimize_vertex_fetch_);
+          ImGui::MenuItem("Build Clusters", nullptr, &build_clusters_);
+          ImGui::MenuItem("Generate LODs", nullptr, &generate_lods_);
+          ImGui::MenuItem("Bake Ambient Occlusion", nullptr, &bake_ambient_occlusion_);
+          ImGui::MenuItem("Release After Upload", nullptr, &release_after_upload_);
+          ImGui::MenuItem("Batch Small Geometries", nullptr, &batch_small_geometries_);
+          ImGui::EndMenu();
+        }
+
         ImGui::Separator();
 
         if (ImGui::MenuItem(u8"Exit", "CTRL+X")) {
@@ -40,6 +66,46 @@ namespace Dental::UI {
           }
         }
 
+        ImGui::Separator();
+
+        auto& governor = engine_.viewer()->governor();
+        bool dynamic_resolution = governor.dynamicResolution();
+        if (ImGui::MenuItem("Dynamic Resolution", nullptr, &dynamic_resolution)) {
+          governor.dynamicResolution(dynamic_resolution);
+        }
+
+        int target_fps = (int)(1.f / governor.targetFrameTime() + 0.5f);
+        if (ImGui::SliderInt("Target FPS", &target_fps, 20, 144)) {
+          governor.targetFrameTime(1.f / target_fps);
+        }
+
+        float min_scale = governor.minScale();
+        if (ImGui::SliderFloat("Min Scale", &min_scale, 0.25f, 1.f, "%.2f")) {
+          governor.minScale(min_scale);
+        }
+
+        ImGui::Separator();
+
+        auto& viewer = engine_.viewer();
+        auto edge_overlays = viewer->edgeOverlays();
+        auto edgeItem = [&](const char* label, Geometry::Overlay overlay) {
+          auto bit = 1u << (unsigned int)overlay;
+          bool visible = (edge_overlays & bit) != 0;
+          if (ImGui::MenuItem(label, nullptr, &visible)) {
+            viewer->edgeOverlays(visible ? edge_overlays | bit : edge_overlays & ~bit);
+          }
+        };
+        edgeItem("Wireframe", Geometry::Overlay::EDGES);
+        edgeItem("Boundary Edges", Geometry::Overlay::BOUNDARY_EDGES);
+        edgeItem("Crease Edges", Geometry::Overlay::CREASE_EDGES);
+
+        ImGui::Separator();
+
+        bool ambient_occlusion = viewer->ambientOcclusion();
+        if (ImGui::MenuItem("Ambient Occlusion", nullptr, &ambient_occlusion)) {
+          viewer->ambientOcclusion(ambient_occlusion);
+        }
+
         ImGui::EndMenu();
       }
     }
@@ -48,16 +114,70 @@ namespace Dental::UI {
     static std::string error_message;
     if (ifd::FileDialog::Instance().IsDone("ImportFileDialog")) {
       if (ifd::FileDialog::Instance().HasResult()) {
-        auto result = ReaderWriter::read(ifd::FileDialog::Instance().GetResult().string());
+        auto result = ReaderWriter::read(ifd::FileDialog::Instance().GetResult().string(), readOptions());
         auto geometry = std::get<0>(result);
         if (geometry) {
-          engine_.viewer()->scene()->addGeometry(geometry);
+          auto& scene = engine_.viewer()->scene();
+          // 同一technique实例的小模型才能合并到一次绘制中
+          if (batch_small_geometries_ && BatchGeometry::batchable(*geometry)) {
+            geometry->renderTechnique(batch_technique_);
+          }
+          scene->addGeometry(geometry);
+          if (batch_small_geometries_) {
+            BatchGeometry::merge(*scene);
+          }
           engine_.viewer()->home();
+          if (!std::get<2>(result).empty()) {
+            std::cout << std::get<2>(result) << std::endl;
+          }
         } else {
           std::cout << std::get<2>(result) << std::endl;
         }
       }
       ifd::FileDialog::Instance().Close();
     }
+
+    if (ifd::FileDialog::Instance().IsDone("PlaceComponentDialog")) {
+      if (ifd::FileDialog::Instance().HasResult()) {
+        placeComponent(ifd::FileDialog::Instance().GetResult().string());
+      }
+      ifd::FileDialog::Instance().Close();
+    }
+  }
+
+  ReaderWriter::ReadOptions MenuBar::readOptions() const {
+    ReaderWriter::ReadOptions options;
+    options.optimizeVertexCache(optimize_vertex_cache_);
+    options.optimizeVertexFetch(optimize_vertex_fetch_);
+    options.buildClusters(build_clusters_);
+    options.generateLods(generate_lods_);
+    options.bakeAmbientOcclusion(bake_ambient_occlusion_);
+    options.releaseAfterUpload(release_after_upload_);
+    return options;
+  }
+
+  void MenuBar::placeComponent(const std::string& path) {
+    auto& scene = engine_.viewer()->scene();
+    auto itr = components_.find(path);
+    // 部件被移出场景后重新读取
+    if (itr == components_.end() || scene->geometryIndex(itr->second) < 0) {
+      auto result = ReaderWriter::read(path, readOptions());
+      auto geometry = std::get<0>(result);
+      if (!geometry) {
+        std::cout << std::get<2>(result) << std::endl;
+        return;
+      }
+
+      auto component = std::make_shared<InstancedGeometry>(geometry);
+      scene->addGeometry(component);
+      itr = components_.insert_or_assign(path, component).first;
+    }
+
+    // 新实例沿x轴排在已有实例之后
+    auto& component = itr->second;
+    auto& box = component->source()->localBoundingBox();
+    auto step = box.valid() ? (box.max().x - box.min().x) * 1.2f : 0.f;
+    component->addInstance(glm::translate(glm::vec3(step * component->numInstances(), 0.f, 0.f)));
+    engine_.viewer()->home();
   }
 }
\ No newline at end of file
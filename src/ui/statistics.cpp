@@ -0,0 +1,68 @@
+#include "../external/imgui/imgui.h"
+#include <ui/statistics.h>
+#include <engine.h>
+#include <gl_state.h>
+#include <program.h>
+#include <geometry.h>
+#include <render_queue.h>
+#include <render_visitor.h>
+#include <upload_scheduler.h>
+#include <render_target_pool.h>
+#include <edge_extractor.h>
+
+namespace Dental::UI {
+  Statistics::Statistics(Engine& engine, const std::string& name, bool visible) :
+    View(engine, name, visible) {
+  }
+
+  Statistics::~Statistics() {
+  }
+
+  void Statistics::render() {
+    if (!Visible) {
+      return;
+    }
+
+    // 在所有视图之后绘制, 计数为本帧所有Viewer的总和
+    if (ImGui::Begin(Name.c_str(), &Visible)) {
+      auto& queue = RenderQueue::statistics();
+      auto& state = GLState::instance().statistics();
+
+      if (ImGui::BeginTable("##statistics_table", 2, ImGuiTableFlags_SizingStretchProp)) {
+        auto row = [](const char* label, unsigned int value) {
+          ImGui::TableNextRow();
+          ImGui::TableSetColumnIndex(0);
+          ImGui::Text("%s", label);
+          ImGui::TableSetColumnIndex(1);
+          ImGui::Text("%u", value);
+        };
+
+        row("geometries drawn", RenderVisitor::statistics().drawn);
+        row("geometries culled", RenderVisitor::statistics().culled);
+        row("geometries occluded", RenderVisitor::statistics().occluded);
+        row("geometries simplified", RenderVisitor::statistics().simplified);
+        row("clusters drawn", RenderVisitor::statistics().clusters_drawn);
+        row("clusters culled", RenderVisitor::statistics().clusters_culled);
+        row("reduced quality", engine_.viewer()->governor().interactive() ? 1 : 0);
+        row("resolution scale (%)", (unsigned int)(engine_.viewer()->governor().resolutionScale() * 100.f + 0.5f));
+        row("queue items", queue.items);
+        row("draw calls", PrimitiveSet::drawCalls());
+        row("program changes", queue.program_changes);
+        row("texture changes", queue.texture_changes);
+        row("gl state calls", state.calls);
+        row("gl state skipped", state.skipped);
+        row("uniform skipped", Program::skippedUploads());
+        row("depth passes skipped", ShadowRenderTechnique::skippedDepthPasses());
+        row("edge extraction (ms)", (unsigned int)(EdgeExtractor::instance().milliseconds() + 0.5f));
+        row("upload bytes", (unsigned int)UploadScheduler::instance().statistics().uploaded);
+        row("upload throttled", UploadScheduler::instance().statistics().throttled);
+        row("cpu released (KB)", (unsigned int)(Geometry::totalReleasedBytes() / 1024));
+        row("render targets", (unsigned int)RenderTargetPool::instance().size());
+        row("render targets (KB)", (unsigned int)(RenderTargetPool::instance().memory() / 1024));
+
+        ImGui::EndTable();
+      }
+    }
+    ImGui::End();
+  }
+}
@@ -5,7 +5,14 @@
 
 namespace Dental::UI {
   UnderCut::UnderCut(Engine& engine, const std::string& name, bool visible) :
-    View(engine, name, visible) {
+    View(engine, name, visible),
+    rendered_geometry_(nullptr),
+    rendered_revision_(0),
+    rendered_model_(glm::identity<glm::mat4>()),
+    rendered_insertion_(glm::identity<glm::mat4>()),
+    rendered_width_(0),
+    rendered_height_(0),
+    rendered_uploaded_(false) {
   }
 
   UnderCut::~UnderCut() {
@@ -17,6 +24,62 @@ namespace Dental::UI {
       viewer.scene()->clearGeometry();
       viewer.scene()->addGeometry(geometry);
     }
+    rendered_geometry_ = nullptr;
+  }
+
+  bool UnderCut::dirty(int width, int height) const {
+    if (rendered_geometry_ != geometry_.get() || rendered_revision_ != geometry_->revision() ||
+        rendered_model_ != geometry_->mv() || rendered_width_ != width || rendered_height_ != height) {
+      return true;
+    }
+
+    // 上次绘制时geometry还没有上传完, 画面不完整
+    if (!rendered_uploaded_) {
+      return true;
+    }
+
+    auto render = std::dynamic_pointer_cast<ShadowRenderTechnique>(geometry_->renderTechnique());
+    return render && rendered_insertion_ != render->mv();
+  }
+
+  void UnderCut::renderViews(int width, int height) {
+    bool uploaded = true;
+    glm::quat quat(glm::identity<glm::quat>());
+    quat = glm::rotate(quat, glm::radians(-90.f), glm::vec3(1.f, 0.f, 0.f));
+    quat = glm::rotate(quat, glm::radians(-180.f), glm::vec3(0.f, 0.f, 1.f));
+
+    for (std::size_t i = 0; i < viewers_.size(); ++i) {
+      auto& target = targets_[i];
+      if (!target) {
+        target = std::make_shared<GLFrameTextureBuffer>();
+        target->attachColor();
+      }
+      target->resize(width, height);
+      target->bind();
+
+      // 沿用窗口的清屏颜色
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+      auto& viewer = viewers_[i];
+      quat = glm::rotate(quat, glm::radians(90.f), glm::vec3(0.f, 0.f, 1.f));
+      viewer.scene()->viewport(0, 0, width, height);
+      viewer.home(0, quat, 0.5f);
+      viewer.frame();
+
+      // 绘制的可能是简化层级
+      uploaded = uploaded && geometry_->lodGeometry(geometry_->lod()).uploaded();
+
+      target->unbind();
+    }
+
+    rendered_geometry_ = geometry_.get();
+    rendered_revision_ = geometry_->revision();
+    rendered_model_ = geometry_->mv();
+    auto render = std::dynamic_pointer_cast<ShadowRenderTechnique>(geometry_->renderTechnique());
+    rendered_insertion_ = render ? render->mv() : glm::identity<glm::mat4>();
+    rendered_width_ = width;
+    rendered_height_ = height;
+    rendered_uploaded_ = uploaded;
   }
 
   void UnderCut::render() {
@@ -87,17 +150,22 @@ namespace Dental::UI {
       auto& viewport = engine_.viewer()->scene()->viewport();
       auto width = viewport.width() / 3;
       auto height = viewport.height() / 4;
+      if (width <= 0 || height <= 0) {
+        return;
+      }
 
-      glm::quat quat(glm::identity<glm::quat>());
-      quat = glm::rotate(quat, glm::radians(-90.f), glm::vec3(1.f, 0.f, 0.f));
-      quat = glm::rotate(quat, glm::radians(-180.f), glm::vec3(0.f, 0.f, 1.f));
+      if (dirty(width, height)) {
+        renderViews(width, height);
+      }
 
-      for (int i = 0; i < viewers_.size(); ++i) {
-        auto& viewer = viewers_[i];
-        quat = glm::rotate(quat, glm::radians(90.f), glm::vec3(0.f, 0.f, 1.f));
-        viewer.scene()->viewport(width * i, 0, width, height);
-        viewer.home(0, quat, 0.5f);
-        viewer.frame();
+      // 纹理以图片绘制在窗口底部, 帧缓冲像素换算为ImGui坐标, 纹理的原点在左下角
+      ImGuiIO& io = ImGui::GetIO();
+      auto scale = io.DisplayFramebufferScale;
+      auto draw_list = ImGui::GetBackgroundDrawList();
+      for (std::size_t i = 0; i < targets_.size(); ++i) {
+        ImVec2 min((viewport.x() + width * i) / scale.x, io.DisplaySize.y - (viewport.y() + height) / scale.y);
+        ImVec2 max(min.x + width / scale.x, min.y + height / scale.y);
+        draw_list->AddImage((ImTextureID)(intptr_t)targets_[i]->color(), min, max, ImVec2(0.f, 1.f), ImVec2(1.f, 0.f));
       }
     }
   }
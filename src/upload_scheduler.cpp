@@ -0,0 +1,48 @@
+#include <algorithm>
+#include <upload_scheduler.h>
+
+namespace Dental {
+  UploadScheduler::UploadScheduler() :
+    budget_(DEFAULT_BUDGET),
+    remaining_(DEFAULT_BUDGET),
+    pending_(false),
+    statistics_({ 0, 0 }) {
+  }
+
+  UploadScheduler& UploadScheduler::instance() {
+    static UploadScheduler scheduler;
+    return scheduler;
+  }
+
+  void UploadScheduler::frame() {
+    remaining_ = budget_;
+    pending_ = false;
+    statistics_ = { 0, 0 };
+  }
+
+  GLsizeiptr UploadScheduler::acquire(GLsizeiptr bytes, GLsizeiptr granularity) {
+    if (bytes <= 0) {
+      return 0;
+    }
+
+    GLsizeiptr granted = bytes;
+    if (budget_ > 0) {
+      granted = std::min(bytes, remaining_);
+      granted -= granted % std::max<GLsizeiptr>(granularity, 1);
+
+      // 预算比一个元素还小时至少保证每帧有进展
+      if (granted <= 0 && remaining_ == budget_) {
+        granted = std::min(bytes, granularity);
+      }
+      remaining_ = std::max<GLsizeiptr>(remaining_ - granted, 0);
+    }
+
+    if (granted < bytes) {
+      pending_ = true;
+      ++statistics_.throttled;
+    }
+
+    statistics_.uploaded += granted;
+    return granted;
+  }
+}
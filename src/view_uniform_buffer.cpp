@@ -0,0 +1,66 @@
+#include <cstring>
+#include <glad/glad.h>
+#include <view_uniform_buffer.h>
+#include <gl_state.h>
+
+namespace {
+  // 两个阶段都声明时精度必须一致
+  const char* view_block_source = R"(layout (std140) uniform View {
+  highp mat4 uProjection;
+  highp mat4 uView;
+  highp vec4 uViewport;
+  highp vec4 uLightPosition;
+};
+)";
+}
+
+namespace Dental {
+  const char* ViewUniformBuffer::blockName() {
+    return "View";
+  }
+
+  std::string ViewUniformBuffer::inject(const std::string& source) {
+    auto pos = source.find('\n');
+    if (pos == std::string::npos || source.compare(0, 8, "#version")) {
+      return view_block_source + source;
+    }
+    return source.substr(0, pos + 1) + view_block_source + source.substr(pos + 1);
+  }
+
+  ViewUniformBuffer::ViewUniformBuffer() :
+    buffer_(std::make_shared<GLBufferObject>(GL_UNIFORM_BUFFER, 1)) {
+    block_.projection = glm::identity<glm::mat4>();
+    block_.view = glm::identity<glm::mat4>();
+    block_.viewport = glm::vec4(0.f);
+    block_.light = glm::vec4(0.f, 0.f, 100.f, 1.f);
+    buffer_->scheduled(false);
+    buffer_->bindData(sizeof(Block), &block_);
+  }
+
+  ViewUniformBuffer::~ViewUniformBuffer() {
+  }
+
+  void ViewUniformBuffer::light(const glm::vec4& position) {
+    if (block_.light != position) {
+      block_.light = position;
+      buffer_->dirty();
+    }
+  }
+
+  void ViewUniformBuffer::update(const glm::mat4& projection, const glm::mat4& view, const Viewport& viewport) {
+    Block block = block_;
+    block.projection = projection;
+    block.view = view;
+    block.viewport = glm::vec4(viewport.x(), viewport.y(), viewport.width(), viewport.height());
+
+    if (std::memcmp(&block, &block_, sizeof(Block))) {
+      block_ = block;
+      buffer_->dirty();
+    }
+  }
+
+  void ViewUniformBuffer::bind() {
+    buffer_->sync();
+    GLState::instance().bindBufferBase(GL_UNIFORM_BUFFER, BINDING, buffer_->id());
+  }
+}
@@ -6,7 +6,10 @@ namespace Dental {
   Viewer::Viewer() :
     scene_(std::make_shared<Scene>()),
     manipulator_(std::make_shared<Manipulator>()),
-    move_event_(Event::POINTER_MOVE, Event::LEFT_BUTTON, 0.f, 0.f) {
+    view_uniform_buffer_(std::make_shared<ViewUniformBuffer>()),
+    move_event_(Event::POINTER_MOVE, Event::LEFT_BUTTON, 0.f, 0.f),
+    edge_overlays_(0),
+    ambient_occlusion_(true) {
     manipulator_->camera(std::dynamic_pointer_cast<Camera>(scene_));
   }
 
@@ -46,11 +49,66 @@ namespace Dental {
     render(render_info);
   }
 
+  bool Viewer::needRedraw() {
+    return manipulator_->moving() || governor_.pending();
+  }
+
   void Viewer::render(RenderInfoPtr& render_info) {
-    RenderVisitor visitor(render_info);
+    governor_.update(manipulator_->moving());
+    render_info->interactive(governor_.interactive());
+    render_info->ambientOcclusion(ambient_occlusion_);
+
+    if (governor_.resolutionScale() < 1.f) {
+      renderReduced(render_info);
+      return;
+    }
+
+    RenderVisitor visitor(render_info, view_uniform_buffer_);
+    setupVisitor(visitor);
     scene_->accept(visitor);
   }
 
+  void Viewer::setupVisitor(RenderVisitor& visitor) {
+    if (!edge_overlays_) {
+      return;
+    }
+
+    if (!edge_technique_) {
+      edge_technique_ = std::make_shared<EdgeRenderTechnique>();
+    }
+    edge_technique_->overlays(edge_overlays_);
+    visitor.edgeTechnique(edge_technique_);
+  }
+
+  void Viewer::renderReduced(RenderInfoPtr& render_info) {
+    auto& viewport = scene_->viewport();
+    auto scale = governor_.resolutionScale();
+    auto scaled = QualityGovernor::scale(viewport, scale);
+
+    if (!reduced_buffer_) {
+      reduced_buffer_ = std::make_shared<GLFrameRenderBuffer>();
+      reduced_buffer_->multiSample(0);
+      reduced_buffer_->attachColor();
+    }
+    reduced_buffer_->resize(scaled.x() + scaled.width(), scaled.y() + scaled.height());
+    reduced_buffer_->bind();
+
+    // 沿用窗口的清屏颜色
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    {
+      RenderVisitor visitor(render_info, view_uniform_buffer_);
+      visitor.resolutionScale(scale);
+      setupVisitor(visitor);
+      scene_->accept(visitor);
+    }
+
+    // 颜色线性放大, 深度一并拷贝供之后的绘制使用, 拷贝后绑定回默认帧缓冲
+    reduced_buffer_->blit(scaled.x(), scaled.y(), scaled.width(), scaled.height(),
+                          viewport.x(), viewport.y(), viewport.width(), viewport.height());
+    viewport.apply();
+  }
+
   bool Viewer::handleEvent(Event &event) {
     return manipulator_->handleEvent(event);
   }
@@ -1,5 +1,6 @@
 #include <glad/glad.h>
 #include <viewport.h>
+#include <gl_state.h>
 
 namespace Dental {
   Viewport::Viewport() : x_(0), y_(0), width_(600), height_(400) {
@@ -111,6 +112,6 @@ namespace Dental {
   }
 
   void Viewport::apply() const {
-    glViewport(x_, y_, width_, height_);
+    GLState::instance().viewport(x_, y_, width_, height_);
   }
 }
\ No newline at end of file